@@ -1,6 +1,7 @@
 #include "app.h"
 #include "ui.h"
 #include "palette.h"
+#include "startup_profile.h"
 
 /* ---------------------------------------------------------------------------
  * Lifecycle
@@ -15,6 +16,7 @@ App *app_create(SDL_Window *win, SDL_Renderer *ren)
 
     app->win = win;
     app->ren = ren;
+    frame_pacer_init(&app->pacer, win, ren);
     app->window_w = INITIAL_WINDOW_WIDTH;
     app->window_h = INITIAL_WINDOW_HEIGHT;
 
@@ -26,6 +28,7 @@ App *app_create(SDL_Window *win, SDL_Renderer *ren)
     if (!app->palette) {
         goto fail;
     }
+    startup_profile_mark("palette");
 
     app->show_color_palette = true;
     app->show_emoji_palette = true;
@@ -62,24 +65,45 @@ App *app_create(SDL_Window *win, SDL_Renderer *ren)
     app->emoji_selected_palette_idx = app->palette->total_color_cells;
 
     app->brush_radius = 10;
+    SDL_zero(app->brush_spans);
     app_recalculate_sizes_and_limits(app);
 
     app->canvas_texture = NULL;
+    app->canvas_texture_w = 0;
+    app->canvas_texture_h = 0;
+    app->canvas_capacity_w = 0;
+    app->canvas_capacity_h = 0;
+    SDL_zero(app->canvas_tiles);
+    history_init(&app->history, history_budget_from_hint());
     app->stroke_buffer = NULL;
     app->blur_source_texture = NULL;
-    app->blur_dab_texture = NULL;
+    SDL_zero(app->blur_mask);
+    app->preview_ring_texture = NULL;
+    app->preview_ring_radius = 0;
+    app->scene_texture = NULL;
+    damage_clear(&app->damage);
+    SDL_zero(app->line_preview_rect);
+    SDL_zero(app->prediction_rect);
+    stroke_batch_init(&app->dab_batch);
+    app->raster = tile_raster_create(ren);
     app_recreate_canvas_texture(app);
+    startup_profile_mark("canvas");
 
+    app->recorder = NULL;
     app->running = true;
     app->needs_redraw = true;
     app->resize_pending = false;
     app->last_resize_timestamp = 0;
     app->is_buffered_stroke_active = false;
     app->line_mode_toggled_on = false;
+    app->held_modifiers = SDL_KMOD_NONE;
     app->is_drawing = false;
     app->straight_line_stroke_latched = false;
     app->last_stroke_x = -1.0f;
     app->last_stroke_y = -1.0f;
+    stroke_reset(&app->stroke);
+    SDL_zero(app->motion);
+    stroke_predictor_reset(&app->predictor);
     app->has_moved_since_mousedown = false;
 
     return app;
@@ -97,6 +121,12 @@ void app_destroy(App *app)
     if (!app) {
         return;
     }
+    stroke_batch_free(&app->dab_batch);
+    tile_raster_destroy(app->raster);
+    stroke_samples_free(&app->motion);
+    circle_spans_free(&app->brush_spans);
+    history_free(&app->history);
+    canvas_tiles_free(&app->canvas_tiles);
     if (app->canvas_texture) {
         SDL_DestroyTexture(app->canvas_texture);
     }
@@ -106,11 +136,12 @@ void app_destroy(App *app)
     if (app->blur_source_texture) {
         SDL_DestroyTexture(app->blur_source_texture);
     }
-    if (app->blur_dab_texture) {
-        SDL_DestroyTexture(app->blur_dab_texture);
+    blur_mask_free(&app->blur_mask);
+    if (app->preview_ring_texture) {
+        SDL_DestroyTexture(app->preview_ring_texture);
     }
-    if (app->blur_temp_texture) {
-        SDL_DestroyTexture(app->blur_temp_texture);
+    if (app->scene_texture) {
+        SDL_DestroyTexture(app->scene_texture);
     }
     palette_destroy(app->palette);
     SDL_free(app);
@@ -1,6 +1,16 @@
 #pragma once
 
+#include "blur.h"
+#include "canvas_tiles.h"
+#include "damage.h"
+#include "frame_pacer.h"
+#include "history.h"
 #include "palette.h"
+#include "perf_hud.h"
+#include "replay.h"
+#include "stroke.h"
+#include "stroke_batch.h"
+#include "tile_raster.h"
 #include "tool.h"
 
 typedef struct App {
@@ -8,15 +18,30 @@ typedef struct App {
     SDL_Renderer *ren;
 
     SDL_Texture *canvas_texture;
-    int canvas_texture_w;
+    int canvas_texture_w; // Size of the visible canvas (the viewport into the textures)
     int canvas_texture_h;
+    int canvas_capacity_w; // Allocated size of every window-sized texture
+    int canvas_capacity_h;
+    CanvasTiles canvas_tiles; // CPU copy of the canvas, kept in sync at stroke boundaries
+    History history;          // Undo/redo steps over canvas_tiles
     // Calculated height of the canvas display area in the window
     int canvas_display_area_h;
 
     SDL_Texture *stroke_buffer; // For tools that need to be blended as a whole stroke
     SDL_Texture *blur_source_texture; // For the blur tool to read from
-    SDL_Texture *blur_dab_texture;    // Reusable texture for individual blur dabs
-    SDL_Texture *blur_temp_texture;   // For multi-pass blur
+    BlurMask blur_mask;               // Coverage of the blur stroke in progress
+
+    StrokeBatch dab_batch; // Dabs queued during one event drain, drawn with a single call
+    TileRaster *raster;    // Draws brush and eraser dabs into canvas_tiles instead; may be NULL
+
+    SDL_Texture *preview_ring_texture; // Brush size preview in the tool selector
+    int preview_ring_radius;           // Radius preview_ring_texture was built (or failed) for
+
+    SDL_Texture *scene_texture; // Last composited frame, so a redraw can be limited to damage
+    DamageList damage;          // Regions to recomposite when needs_redraw is not set
+    FramePacer pacer;           // When to render the next frame
+    SDL_Rect line_preview_rect; // Area covered by the current straight-line preview
+    SDL_Rect prediction_rect;   // Area of the predicted stroke tip in stroke_buffer; empty if none
 
     Palette *palette;
 
@@ -31,13 +56,16 @@ typedef struct App {
     SDL_Color background_color;   // Current canvas background color
 
     int brush_radius;
-    int max_brush_radius; // Max allowed brush radius, dynamically calculated
+    int max_brush_radius;    // Max allowed brush radius, dynamically calculated
+    CircleSpans brush_spans; // Cached dab shape for brush_radius
 
     int window_w;
     int window_h;
 
+    ReplayRecorder *recorder; // NULL unless recording input with --record
+
     bool running;
-    bool needs_redraw;
+    bool needs_redraw; // Recomposite the whole window; use damage for partial updates
 
     // For resize debouncing
     bool resize_pending;
@@ -45,6 +73,8 @@ typedef struct App {
 
     // UI state
     bool line_mode_toggled_on;
+    SDL_Keymod held_modifiers; // Ctrl and Shift keys down, from handled key events (not polled,
+                               // so a replay sees the same keys as the recording)
     bool show_color_palette;
     bool show_emoji_palette;
 
@@ -54,6 +84,9 @@ typedef struct App {
     bool straight_line_stroke_latched;
     float last_stroke_x;
     float last_stroke_y;
+    Stroke stroke;        // Dab placement along the current freehand stroke
+    StrokeSamples motion; // Pointer motion queued since the last app_flush_input
+    StrokePredictor predictor;
     bool has_moved_since_mousedown;
 } App;
 
@@ -64,6 +97,7 @@ void app_destroy(App *app);
 /* --- Event Handling (app_keyboard.c, app_mouse.c) --- */
 void app_handle_keydown(App *app, const SDL_KeyboardEvent *key_event);
 void app_handle_keyup(App *app, const SDL_KeyboardEvent *key_event);
+void app_handle_focus_lost(App *app);
 void app_handle_mousedown(App *app, const SDL_MouseButtonEvent *mouse_event);
 void app_handle_mouseup(App *app, const SDL_MouseButtonEvent *mouse_event);
 void app_handle_mousewheel(
@@ -79,23 +113,45 @@ void app_toggle_emoji_palette(App *app);
 /* --- Drawing & Canvas (app_draw.c, app_canvas.c) --- */
 void app_draw_stroke(App *app, float mouse_x, float mouse_y, bool use_background_color);
 void app_draw_line_of_dabs(App *app, float x0, float y0, float x1, float y1, bool use_background_color);
+void app_flush_dab_batch(App *app);
+void app_queue_motion(App *app, const SDL_MouseMotionEvent *motion);
+void app_flush_input(App *app);
+void app_expire_prediction(App *app);
+void app_reset_prediction(App *app);
 void app_clear_canvas_with_current_bg(App *app);
 void app_set_background_and_clear_canvas(App *app, SDL_Color color);
 void app_recreate_canvas_texture(App *app);
+SDL_FRect app_canvas_viewport(const App *app);
+bool app_render_canvas_layer(App *app, SDL_Texture *tex);
+void app_sync_canvas_tiles(App *app);
+void app_upload_canvas_tiles(App *app, const SDL_Rect *rect);
+void app_undo(App *app);
+void app_redo(App *app);
 
 /* --- Brush (app_brush.c) --- */
 void app_change_brush_radius(App *app, int delta);
 void app_set_brush_radius_from_key(App *app, SDL_Keycode keycode);
+void app_update_brush_spans(App *app);
 
 /* --- Palette & Tool Selection (app_palette.c) --- */
 void app_select_palette_tool(App *app, int palette_idx);
 void app_move_palette_selection(App *app, SDL_Keycode key);
 void app_cycle_palette_selection(App *app, int delta, int palette_type);
 int app_get_current_palette_selection(App *app);
+void app_collect_emoji_glyphs(App *app);
 
 /* --- Window & Resize (app_resize.c) --- */
 void app_notify_resize_event(App *app, int new_w, int new_h);
 void app_process_debounced_resize(App *app);
+// Resizes the window and applies the new layout at once, skipping the debounce.
+// For replays and benchmarks, which drive the window size themselves.
+bool app_apply_resize_now(App *app, int new_w, int new_h);
+
+/* --- Damage Tracking (app_damage.c) --- */
+void app_damage_rect(App *app, const SDL_Rect *rect);
+void app_damage_ui(App *app);
+void app_damage_tool_change(App *app);
+bool app_has_damage(const App *app);
 
 /* --- Layout & Sizing (app_layout.c) --- */
 void app_recalculate_sizes_and_limits(App *app);
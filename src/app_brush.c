@@ -1,4 +1,5 @@
 #include "app.h"
+#include "draw.h"
 #include "ui.h"
 
 void app_change_brush_radius(App *app, int delta)
@@ -13,7 +14,20 @@ void app_change_brush_radius(App *app, int delta)
     if (app->brush_radius > app->max_brush_radius) {
         app->brush_radius = app->max_brush_radius;
     }
-    app->needs_redraw = true;
+    app_update_brush_spans(app);
+    app_damage_ui(app);
+}
+
+// Rebuild the cached dab shape, but only when the radius actually changed.
+void app_update_brush_spans(App *app)
+{
+    if (!app) {
+        return;
+    }
+    if (app->brush_spans.spans && app->brush_spans.radius == app->brush_radius) {
+        return;
+    }
+    circle_spans_build(&app->brush_spans, app->brush_radius);
 }
 
 void app_set_brush_radius_from_key(App *app, SDL_Keycode keycode)
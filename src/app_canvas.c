@@ -10,7 +10,10 @@ void app_clear_canvas_with_current_bg(App *app)
         return;
     }
 
-    if (!SDL_SetRenderTarget(app->ren, app->canvas_texture)) {
+    // Queued dabs belong before the clear, and in their own undo step.
+    app_sync_canvas_tiles(app);
+
+    if (!perf_set_render_target(app->ren, app->canvas_texture)) {
         SDL_Log("Failed to set render target to canvas texture: %s", SDL_GetError());
         return;
     }
@@ -24,12 +27,78 @@ void app_clear_canvas_with_current_bg(App *app)
     if (!SDL_RenderClear(app->ren)) {
         SDL_Log("Failed to clear canvas: %s", SDL_GetError());
     }
-    if (!SDL_SetRenderTarget(app->ren, NULL)) {
+    if (!perf_set_render_target(app->ren, NULL)) {
         SDL_Log("Failed to reset render target: %s", SDL_GetError());
     }
+    history_commit_clear(&app->history, &app->canvas_tiles, app->background_color);
     app->needs_redraw = true;
 }
 
+#define CANVAS_CAPACITY_STEP 256 // Window-sized textures are allocated in multiples of this
+
+// Allocation size for a window dimension: a quarter of headroom, rounded up to a whole step,
+// so that dragging a window edge keeps reusing the same textures for a while.
+static int canvas_capacity_for(int size, int max_size)
+{
+    int cap = size + size / 4;
+    cap = (cap + CANVAS_CAPACITY_STEP - 1) / CANVAS_CAPACITY_STEP * CANVAS_CAPACITY_STEP;
+    if (max_size > 0 && cap > max_size) {
+        cap = SDL_max(size, max_size);
+    }
+    return cap;
+}
+
+// True if the current textures can hold w x h without leaving most of them unused.
+static bool canvas_capacity_fits(const App *app, int w, int h)
+{
+    if (!app->canvas_texture || w > app->canvas_capacity_w || h > app->canvas_capacity_h) {
+        return false;
+    }
+    return (Sint64)w * h * 4 >= (Sint64)app->canvas_capacity_w * app->canvas_capacity_h;
+}
+
+// Fills the part of a w x h canvas outside the old_w x old_h one with the background color.
+// The canvas must be the current render target.
+static void app_fill_exposed_canvas(App *app, int old_w, int old_h, int w, int h)
+{
+    if (!SDL_SetRenderDrawColor(app->ren,
+                                app->background_color.r,
+                                app->background_color.g,
+                                app->background_color.b,
+                                app->background_color.a)) {
+        SDL_Log("Failed to set draw color for new canvas: %s", SDL_GetError());
+    }
+    if (!SDL_SetRenderDrawBlendMode(app->ren, SDL_BLENDMODE_NONE)) {
+        SDL_Log("Failed to set blend mode for canvas fill: %s", SDL_GetError());
+    }
+    if (w > old_w) {
+        SDL_FRect right = {(float)old_w, 0, (float)(w - old_w), (float)h};
+        if (!SDL_RenderFillRect(app->ren, &right)) {
+            SDL_Log("Failed to fill exposed canvas area: %s", SDL_GetError());
+        }
+    }
+    if (h > old_h) {
+        SDL_FRect bottom = {0, (float)old_h, (float)SDL_min(w, old_w), (float)(h - old_h)};
+        if (!SDL_RenderFillRect(app->ren, &bottom)) {
+            SDL_Log("Failed to fill exposed canvas area: %s", SDL_GetError());
+        }
+    }
+}
+
+// The visible part of the window-sized textures, which may be allocated larger.
+SDL_FRect app_canvas_viewport(const App *app)
+{
+    SDL_FRect r = {0, 0, (float)app->canvas_texture_w, (float)app->canvas_texture_h};
+    return r;
+}
+
+// Copies the viewport of a window-sized texture onto the same area of the current target.
+bool app_render_canvas_layer(App *app, SDL_Texture *tex)
+{
+    SDL_FRect r = app_canvas_viewport(app);
+    return SDL_RenderTexture(app->ren, tex, &r, &r);
+}
+
 void app_recreate_canvas_texture(App *app)
 {
     if (!app) {
@@ -38,48 +107,84 @@ void app_recreate_canvas_texture(App *app)
 
     const int w = app->window_w;
     const int h = app->window_h;
+    const int old_w = app->canvas_texture_w;
+    const int old_h = app->canvas_texture_h;
+    if (app->canvas_texture && old_w == w && old_h == h) {
+        app->needs_redraw = true;
+        return;
+    }
+
+    // The batch references the textures about to be destroyed, and strokes drawn
+    // so far must reach the tiles (and the history) while the old canvas exists.
+    app_sync_canvas_tiles(app);
+
+    // Within capacity only the viewport changes; just clear what it newly exposes.
+    if (canvas_capacity_fits(app, w, h)) {
+        if (!perf_set_render_target(app->ren, app->canvas_texture)) {
+            SDL_Log("Failed to set render target to canvas texture: %s", SDL_GetError());
+        } else {
+            app_fill_exposed_canvas(app, old_w, old_h, w, h);
+            if (!perf_set_render_target(app->ren, NULL)) {
+                SDL_Log("Failed to reset render target: %s", SDL_GetError());
+            }
+        }
+        canvas_tiles_resize(&app->canvas_tiles, w, h);
+        app->canvas_texture_w = w;
+        app->canvas_texture_h = h;
+        app->needs_redraw = true;
+        return;
+    }
+
+    int max_size = (int)SDL_GetNumberProperty(
+        SDL_GetRendererProperties(app->ren), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 0);
+    const int cap_w = canvas_capacity_for(w, max_size);
+    const int cap_h = canvas_capacity_for(h, max_size);
 
     SDL_Texture *new_tex =
-        SDL_CreateTexture(app->ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        SDL_CreateTexture(app->ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, cap_w, cap_h);
     if (!new_tex) {
         SDL_Log("Failed to resize canvas texture: %s", SDL_GetError());
         return;
     }
 
-    /* clear new texture with background color */
-    if (!SDL_SetRenderTarget(app->ren, new_tex)) {
+    /* Carry over what still fits, entirely on the GPU */
+    if (!perf_set_render_target(app->ren, new_tex)) {
         SDL_Log("Failed to set render target to new texture: %s", SDL_GetError());
-    } else {
-        if (!SDL_SetRenderDrawColor(app->ren,
-                                    app->background_color.r,
-                                    app->background_color.g,
-                                    app->background_color.b,
-                                    app->background_color.a)) {
-            SDL_Log("Failed to set draw color for new canvas: %s", SDL_GetError());
+    } else if (app->canvas_texture) {
+        SDL_FRect keep = {0, 0, (float)SDL_min(w, old_w), (float)SDL_min(h, old_h)};
+        if (!SDL_SetTextureBlendMode(app->canvas_texture, SDL_BLENDMODE_NONE)) {
+            SDL_Log("Failed to set blend mode for canvas copy: %s", SDL_GetError());
         }
-        if (!SDL_RenderClear(app->ren)) {
-            SDL_Log("Failed to clear new canvas: %s", SDL_GetError());
+        if (!SDL_RenderTexture(app->ren, app->canvas_texture, &keep, &keep)) {
+            SDL_Log("Failed to copy old canvas: %s", SDL_GetError());
         }
+        app_fill_exposed_canvas(app, old_w, old_h, w, h);
+    } else {
+        app_fill_exposed_canvas(app, 0, 0, w, h);
     }
 
-    /* Destroy old canvas texture, no content is preserved on resize */
-    if (app->canvas_texture) {
-        SDL_DestroyTexture(app->canvas_texture);
+    if (!perf_set_render_target(app->ren, NULL)) {
+        SDL_Log("Failed to reset render target: %s", SDL_GetError());
     }
 
-    if (!SDL_SetRenderTarget(app->ren, NULL)) {
-        SDL_Log("Failed to reset render target: %s", SDL_GetError());
+    if (app->canvas_texture) {
+        SDL_DestroyTexture(app->canvas_texture);
+        canvas_tiles_resize(&app->canvas_tiles, w, h);
+    } else {
+        canvas_tiles_init(&app->canvas_tiles, w, h, app->background_color);
     }
     app->canvas_texture = new_tex;
     app->canvas_texture_w = w;
     app->canvas_texture_h = h;
+    app->canvas_capacity_w = cap_w;
+    app->canvas_capacity_h = cap_h;
 
     // Recreate stroke buffer
     if (app->stroke_buffer) {
         SDL_DestroyTexture(app->stroke_buffer);
     }
     app->stroke_buffer =
-        SDL_CreateTexture(app->ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        SDL_CreateTexture(app->ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, cap_w, cap_h);
     if (!app->stroke_buffer) {
         SDL_Log("Failed to create stroke buffer texture: %s", SDL_GetError());
     } else {
@@ -87,7 +192,7 @@ void app_recreate_canvas_texture(App *app)
             SDL_Log("Failed to set blend mode for stroke buffer: %s", SDL_GetError());
         }
         // Clear it to transparent
-        if (!SDL_SetRenderTarget(app->ren, app->stroke_buffer)) {
+        if (!perf_set_render_target(app->ren, app->stroke_buffer)) {
             SDL_Log("Failed to set render target to stroke buffer: %s", SDL_GetError());
         } else {
             if (!SDL_SetRenderDrawBlendMode(app->ren, SDL_BLENDMODE_NONE)) {
@@ -99,37 +204,20 @@ void app_recreate_canvas_texture(App *app)
             if (!SDL_RenderClear(app->ren)) {
                 SDL_Log("Failed to clear stroke buffer: %s", SDL_GetError());
             }
-            if (!SDL_SetRenderTarget(app->ren, NULL)) {
+            if (!perf_set_render_target(app->ren, NULL)) {
                 SDL_Log("Failed to reset render target: %s", SDL_GetError());
             }
         }
     }
 
-    // Recreate blur tool helper resources
+    // Recreate blur tool helper resources; the dab texture is sized by the tool itself.
     if (app->blur_source_texture) {
         SDL_DestroyTexture(app->blur_source_texture);
     }
-    if (app->blur_dab_texture) {
-        SDL_DestroyTexture(app->blur_dab_texture);
-    }
-    if (app->blur_temp_texture) {
-        SDL_DestroyTexture(app->blur_temp_texture);
-    }
-
-    app->blur_dab_texture = SDL_CreateTexture(app->ren,
-                                              SDL_PIXELFORMAT_RGBA8888,
-                                              SDL_TEXTUREACCESS_TARGET,
-                                              BLUR_DAB_DOWNSCALE_SIZE, BLUR_DAB_DOWNSCALE_SIZE);
-
-    app->blur_temp_texture = SDL_CreateTexture(app->ren,
-                                               SDL_PIXELFORMAT_RGBA8888,
-                                               SDL_TEXTUREACCESS_TARGET,
-                                               BLUR_DAB_DOWNSCALE_SIZE, BLUR_DAB_DOWNSCALE_SIZE);
-
     app->blur_source_texture =
-        SDL_CreateTexture(app->ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        SDL_CreateTexture(app->ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, cap_w, cap_h);
 
-    if (!app->blur_dab_texture || !app->blur_temp_texture || !app->blur_source_texture) {
+    if (!app->blur_source_texture) {
         SDL_Log("Failed to create blur helper textures.");
     } else {
         if (!SDL_SetTextureBlendMode(app->blur_source_texture, SDL_BLENDMODE_BLEND)) {
@@ -137,5 +225,72 @@ void app_recreate_canvas_texture(App *app)
         }
     }
 
+    // Recreate the composited frame; it is fully redrawn on the next render.
+    if (app->scene_texture) {
+        SDL_DestroyTexture(app->scene_texture);
+    }
+    app->scene_texture =
+        SDL_CreateTexture(app->ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, cap_w, cap_h);
+    if (!app->scene_texture) {
+        SDL_Log("Failed to create scene texture: %s", SDL_GetError());
+    } else if (!SDL_SetTextureBlendMode(app->scene_texture, SDL_BLENDMODE_NONE)) {
+        SDL_Log("Failed to set blend mode for scene texture: %s", SDL_GetError());
+    }
+
     app->needs_redraw = true;
 }
+
+// Brings the CPU tiles up to date with everything drawn into the canvas texture so far,
+// recording the change as one undo step.
+void app_sync_canvas_tiles(App *app)
+{
+    if (!app || !app->canvas_texture) {
+        return;
+    }
+    app_flush_dab_batch(app);
+    // CPU-drawn tiles go out first, so reading back the texture cannot undo them.
+    canvas_tiles_upload(&app->canvas_tiles, app->canvas_texture);
+    history_commit_stroke(&app->history, &app->canvas_tiles, app->ren, app->canvas_texture);
+}
+
+// Uploads the CPU-drawn tiles under rect (the whole canvas if NULL) before the GPU
+// draws into or reads from that part of the canvas texture.
+void app_upload_canvas_tiles(App *app, const SDL_Rect *rect)
+{
+    if (!app || !app->canvas_texture) {
+        return;
+    }
+    if (rect) {
+        canvas_tiles_upload_rect(&app->canvas_tiles, app->canvas_texture, rect);
+    } else {
+        canvas_tiles_upload(&app->canvas_tiles, app->canvas_texture);
+    }
+}
+
+// Pushes restored tiles to the texture right away, so tools reading the canvas see them.
+static void app_apply_history_step(App *app)
+{
+    app->background_color = app->canvas_tiles.clear_color;
+    canvas_tiles_upload(&app->canvas_tiles, app->canvas_texture);
+    app->needs_redraw = true;
+}
+
+void app_undo(App *app)
+{
+    if (!app || !app->canvas_texture || app->is_drawing) {
+        return;
+    }
+    if (history_undo(&app->history, &app->canvas_tiles)) {
+        app_apply_history_step(app);
+    }
+}
+
+void app_redo(App *app)
+{
+    if (!app || !app->canvas_texture || app->is_drawing) {
+        return;
+    }
+    if (history_redo(&app->history, &app->canvas_tiles)) {
+        app_apply_history_step(app);
+    }
+}
@@ -0,0 +1,47 @@
+#include "app.h"
+#include "ui.h"
+
+// Marks a region of the window as changed so the next frame redraws it.
+void app_damage_rect(App *app, const SDL_Rect *rect)
+{
+    if (!app || !rect) {
+        return;
+    }
+    SDL_Rect window_r = {0, 0, app->window_w, app->window_h};
+    SDL_Rect clipped;
+    if (!SDL_GetRectIntersection(rect, &window_r, &clipped)) {
+        return;
+    }
+    damage_add(&app->damage, &clipped);
+}
+
+// Marks the tool selectors and palette, which float at the bottom of the window, as changed.
+void app_damage_ui(App *app)
+{
+    if (!app) {
+        return;
+    }
+    int ui_top = app->canvas_display_area_h - TOOL_SELECTOR_AREA_HEIGHT;
+    if (ui_top < 0) {
+        ui_top = 0;
+    }
+    SDL_Rect r = {0, ui_top, app->window_w, app->window_h - ui_top};
+    app_damage_rect(app, &r);
+}
+
+// A tool switch redraws the selectors; mid-stroke it also changes how the canvas is composited.
+void app_damage_tool_change(App *app)
+{
+    if (!app) {
+        return;
+    }
+    if (app->is_drawing) {
+        app->needs_redraw = true;
+    }
+    app_damage_ui(app);
+}
+
+bool app_has_damage(const App *app)
+{
+    return app && !damage_is_empty(&app->damage);
+}
@@ -1,66 +1,291 @@
 #include "app.h"
+#include "color_utils.h"
 #include "draw.h"
-
-#include "app.h"
-#include "draw.h"
+#include "ui.h"
 
 typedef struct {
     App *app;
     bool use_background_color;
 } DabInfo;
 
-static void app_draw_dab_callback(int x, int y, void *userdata)
+// Round brushes and the eraser go to the CPU rasterizer when there is one.
+static bool app_draws_on_cpu(const App *app, bool use_background_color)
+{
+    return app->raster && (use_background_color || app->current_tool == TOOL_BRUSH);
+}
+
+// Cuts a segment off where it leaves the canvas area above the palette, so a fast
+// stroke still reaches the edge. Returns false if nothing of it is on the canvas.
+static bool app_clip_segment_to_canvas(const App *app, float *x0, float *y0, float *x1, float *y1)
+{
+    float limit = (float)app->canvas_display_area_h - 1.0f;
+    if (limit < 0.0f || (*y0 > limit && *y1 > limit)) {
+        return false;
+    }
+    if (*y0 > limit) {
+        *x0 += (*x1 - *x0) * (limit - *y0) / (*y1 - *y0);
+        *y0 = limit;
+    } else if (*y1 > limit) {
+        *x1 = *x0 + (*x1 - *x0) * (limit - *y0) / (*y1 - *y0);
+        *y1 = limit;
+    }
+    return true;
+}
+
+static void app_draw_dab_callback(float x0, float y0, float x1, float y1, void *userdata)
 {
     DabInfo *info = (DabInfo *)userdata;
     App *app = info->app;
+    PERF_COUNT(dabs);
 
-    if (y >= app->canvas_display_area_h || app->canvas_display_area_h == 0) {
+    if (!app_clip_segment_to_canvas(app, &x0, &y0, &x1, &y1)) {
         return;
     }
 
-    if (info->use_background_color) {
-        if (!SDL_SetRenderTarget(app->ren, app->canvas_texture)) {
-            SDL_Log("Failed to set render target for eraser dab: %s", SDL_GetError());
-            return;
-        }
-        if (!SDL_SetRenderDrawColor(app->ren,
-                                    app->background_color.r,
-                                    app->background_color.g,
-                                    app->background_color.b,
-                                    app->background_color.a)) {
-            SDL_Log("Failed to set color for eraser dab: %s", SDL_GetError());
-        }
-        draw_circle(app->ren, (float)x, (float)y, app->brush_radius);
-        if (!SDL_SetRenderTarget(app->ren, NULL)) {
-            SDL_Log("Failed to reset render target after eraser dab: %s", SDL_GetError());
+    if (app_draws_on_cpu(app, info->use_background_color)) {
+        SDL_Color color = app->background_color;
+        if (!info->use_background_color) {
+            color = app->current_color;
+            color.a = 255;
         }
-        app->needs_redraw = true;
+        tile_raster_add_capsule(app->raster, x0, y0, x1, y1, (float)app->brush_spans.radius, color);
+        return;
+    }
+
+    if (info->use_background_color) {
+        stroke_batch_bind(&app->dab_batch, app->ren, app->canvas_texture, NULL);
+        stroke_batch_add_capsule(&app->dab_batch,
+                                 &app->brush_spans,
+                                 x0,
+                                 y0,
+                                 x1,
+                                 y1,
+                                 color_to_fcolor(app->background_color));
         return;
     }
 
     switch (app->current_tool) {
         case TOOL_BRUSH:
-            tool_brush_draw_dab(app, x, y);
+            tool_brush_draw_segment(app, x0, y0, x1, y1);
             break;
         case TOOL_WATER_MARKER:
-            tool_water_marker_draw_dab(app, x, y);
+            tool_water_marker_draw_segment(app, x0, y0, x1, y1);
             break;
         case TOOL_EMOJI:
-            tool_emoji_draw_dab(app, x, y);
-            break;
-        case TOOL_BLUR:
-            tool_blur_draw_dab(app, x, y);
+            tool_emoji_draw_dab(app, x1, y1);
             break;
         default:
             return; // Should not happen
     }
-    app->needs_redraw = true;
 }
 
+// Half the width of the square a single dab of the active tool can touch.
+static int app_dab_half_extent(const App *app, bool use_background_color)
+{
+    if (use_background_color) {
+        return app->brush_radius;
+    }
+    switch (app->current_tool) {
+        case TOOL_WATER_MARKER:
+            return (int)SDL_ceilf(app->brush_radius * 1.5f) + 1;
+        case TOOL_EMOJI: {
+            // Emoji height is six radii; allow for glyphs up to twice as wide as tall.
+            int h = app->brush_radius * 6;
+            return (h < MIN_BRUSH_SIZE * 6 ? MIN_BRUSH_SIZE * 6 : h) + 1;
+        }
+        case TOOL_BLUR:
+            return app->brush_radius * 2 + 1;
+        case TOOL_BRUSH:
+        default:
+            return app->brush_radius;
+    }
+}
+
+// Bounding box of dabs of the given half extent placed along a segment.
+static SDL_Rect segment_bounds(float x0, float y0, float x1, float y1, int half_extent)
+{
+    SDL_Rect r = {
+        (int)SDL_floorf(SDL_min(x0, x1)) - half_extent,
+        (int)SDL_floorf(SDL_min(y0, y1)) - half_extent,
+        (int)SDL_ceilf(SDL_fabsf(x1 - x0)) + 2 * half_extent + 2,
+        (int)SDL_ceilf(SDL_fabsf(y1 - y0)) + 2 * half_extent + 2,
+    };
+    return r;
+}
+
+// Brush and eraser segments become one capsule each. Other tools get dabs placed by
+// app->stroke at an even spacing, with the gaps between them filled by the tool's
+// shape, so the cost follows the segment length over the spacing rather than its
+// length in pixels. Everything is queued into
+// app->dab_batch (or app->raster); the caller decides when to flush so that every dab
+// of an event drain shares one render target bind and one draw call.
 void app_draw_line_of_dabs(App *app, float x0, float y0, float x1, float y1, bool use_background_color)
 {
     DabInfo info = {app, use_background_color};
-    draw_line_bresenham((int)x0, (int)y0, (int)x1, (int)y1, app_draw_dab_callback, &info);
+    SDL_Rect bounds = segment_bounds(x0, y0, x1, y1, app_dab_half_extent(app, use_background_color));
+    if (!app_draws_on_cpu(app, use_background_color)) {
+        // Tiles the rasterizer drew but has not uploaded yet go out before the GPU draws
+        // over them; uploaded at the end of the frame, they would undo its dabs.
+        app_upload_canvas_tiles(app, &bounds);
+    }
+    if (!use_background_color && app->current_tool == TOOL_BLUR) {
+        // Blur adds the whole segment to its stroke mask instead of stamping dabs.
+        tool_blur_draw_line_of_dabs(app, x0, y0, x1, y1);
+    } else if (use_background_color || app->current_tool == TOOL_BRUSH) {
+        // Round brushes are one continuous polyline: a single capsule per motion
+        // segment, whose end circle doubles as the round join with the next one.
+        stroke_line_to(&app->stroke, x0, y0, x1, y1, app_draw_dab_callback, &info);
+    } else {
+        float spacing = app->brush_radius * STROKE_DEFAULT_SPACING;
+        stroke_advance(&app->stroke, x0, y0, x1, y1, spacing, app_draw_dab_callback, &info);
+
+        // The water marker also joins the last dab to the pointer, so the stroke never
+        // trails behind it by up to one spacing. The next dab paints over this join.
+        if (app->current_tool == TOOL_WATER_MARKER) {
+            app_draw_dab_callback(app->stroke.last_x, app->stroke.last_y, x1, y1, &info);
+        }
+    }
+
+    app_damage_rect(app, &bounds);
+    if (!app_draws_on_cpu(app, use_background_color)) {
+        canvas_tiles_mark_rect(&app->canvas_tiles, &bounds, CANVAS_TILE_READBACK);
+    }
+}
+
+void app_flush_dab_batch(App *app)
+{
+    if (!app) {
+        return;
+    }
+    stroke_batch_flush(&app->dab_batch, app->ren);
+    tile_raster_flush(app->raster, &app->canvas_tiles, app->ren, app->canvas_texture);
+}
+
+// Queues a motion sample of the stroke in progress; app_flush_input draws it.
+void app_queue_motion(App *app, const SDL_MouseMotionEvent *motion)
+{
+    bool erase = (motion->state & SDL_BUTTON_RMASK) != 0;
+    if (app->motion.count > 0 && app->motion.erase != erase) {
+        app_flush_input(app);
+    }
+    app->motion.erase = erase;
+
+    StrokeSample sample = {motion->x, motion->y, motion->timestamp, STROKE_DEFAULT_PRESSURE};
+    if (!stroke_samples_push(&app->motion, &sample)) {
+        // Draw the samples already queued first, so the stroke keeps its order.
+        app_flush_input(app);
+        app_draw_stroke(app, motion->x, motion->y, erase);
+    }
+}
+
+// Brush and eraser strokes leave the stroke buffer unused while drawn freehand, so it
+// can hold the predicted tip. The other tools keep their stroke in it.
+static bool app_can_predict(const App *app, bool erase)
+{
+    return app->is_drawing && !app->straight_line_stroke_latched && app->stroke_buffer &&
+           (erase || app->current_tool == TOOL_BRUSH);
+}
+
+// Takes the predicted tip back out of the stroke buffer.
+static void app_clear_prediction(App *app)
+{
+    if (SDL_RectEmpty(&app->prediction_rect)) {
+        return;
+    }
+    SDL_FRect r;
+    SDL_RectToFRect(&app->prediction_rect, &r);
+    SDL_FColor transparent = {0.0f, 0.0f, 0.0f, 0.0f};
+    stroke_batch_bind(&app->dab_batch, app->ren, app->stroke_buffer, NULL);
+    stroke_batch_add_rect(&app->dab_batch, &r, transparent);
+    app_damage_rect(app, &app->prediction_rect);
+    SDL_zero(app->prediction_rect);
+}
+
+// Draws the stretch from the end of the real stroke to where the pointer is predicted
+// to be by the time the frame is shown. It lives in the stroke buffer, never in the
+// canvas, and is cleared before the real stroke is drawn on the next flush.
+static void app_draw_prediction(App *app, bool erase)
+{
+    float x1, y1;
+    if (!stroke_predictor_predict(&app->predictor, STROKE_PREDICT_AHEAD_NS, &x1, &y1)) {
+        return;
+    }
+    float x0 = app->last_stroke_x;
+    float y0 = app->last_stroke_y;
+    if (x0 < 0.0f || !app_clip_segment_to_canvas(app, &x0, &y0, &x1, &y1)) {
+        return;
+    }
+
+    SDL_Color color = erase ? app->background_color : app->current_color;
+    color.a = 255;
+    stroke_batch_bind(&app->dab_batch, app->ren, app->stroke_buffer, NULL);
+    stroke_batch_add_capsule(
+        &app->dab_batch, &app->brush_spans, x0, y0, x1, y1, color_to_fcolor(color));
+    app->prediction_rect = segment_bounds(x0, y0, x1, y1, app->brush_radius);
+    app_damage_rect(app, &app->prediction_rect);
+}
+
+// Forgets the motion history and any predicted tip; for the start and end of a stroke.
+void app_reset_prediction(App *app)
+{
+    stroke_predictor_reset(&app->predictor);
+    SDL_zero(app->prediction_rect);
+}
+
+// Draws the queued motion samples in one pass and flushes the dab batch.
+// A straight-line preview only needs the newest sample. Freehand strokes skip
+// samples closer than one dab spacing to the last point drawn, except the newest,
+// so a burst of reports from a fast-polling mouse adds no work of its own.
+// Brush and eraser strokes then get a predicted tip ahead of the newest sample.
+// Keeps the prediction between events until the pointer has evidently stopped. While
+// samples are queued the predictor has not seen them, and they replace the tip anyway.
+void app_expire_prediction(App *app)
+{
+    float x, y;
+    if (app->motion.count == 0 && !SDL_RectEmpty(&app->prediction_rect) &&
+        !stroke_predictor_predict(&app->predictor, STROKE_PREDICT_AHEAD_NS, &x, &y)) {
+        app_clear_prediction(app);
+        app_flush_dab_batch(app);
+    }
+}
+
+void app_flush_input(App *app)
+{
+    if (!app) {
+        return;
+    }
+    StrokeSamples *m = &app->motion;
+    if (m->count == 0) {
+        app_expire_prediction(app);
+        app_flush_dab_batch(app);
+        return;
+    }
+
+    app_clear_prediction(app);
+    for (int i = 0; i < m->count; ++i) {
+        stroke_predictor_add(&app->predictor, &m->samples[i]);
+    }
+    if (app->straight_line_stroke_latched && !m->erase) {
+        const StrokeSample *newest = &m->samples[m->count - 1];
+        app_draw_stroke(app, newest->x, newest->y, false);
+    } else {
+        float min_step = SDL_max(app->brush_radius * STROKE_DEFAULT_SPACING, STROKE_MIN_SPACING);
+        for (int i = 0; i < m->count; ++i) {
+            const StrokeSample *s = &m->samples[i];
+            float dx = s->x - app->last_stroke_x;
+            float dy = s->y - app->last_stroke_y;
+            if (i < m->count - 1 && app->last_stroke_x >= 0.0f &&
+                dx * dx + dy * dy < min_step * min_step) {
+                continue;
+            }
+            app_draw_stroke(app, s->x, s->y, m->erase);
+        }
+    }
+    if (app_can_predict(app, m->erase)) {
+        app_draw_prediction(app, m->erase);
+    }
+    stroke_samples_clear(m);
+    app_flush_dab_batch(app);
 }
 
 void app_draw_stroke(App *app, float mouse_x, float mouse_y, bool use_background_color)
@@ -74,7 +299,8 @@ void app_draw_stroke(App *app, float mouse_x, float mouse_y, bool use_background
         (app->current_tool == TOOL_BRUSH || app->current_tool == TOOL_WATER_MARKER ||
          app->current_tool == TOOL_EMOJI || app->current_tool == TOOL_BLUR)) {
         // --- Straight Line Preview ---
-        if (!SDL_SetRenderTarget(app->ren, app->stroke_buffer)) {
+        app_flush_dab_batch(app);
+        if (!perf_set_render_target(app->ren, app->stroke_buffer)) {
             SDL_Log("Failed to set render target for preview: %s", SDL_GetError());
             return;
         }
@@ -85,7 +311,7 @@ void app_draw_stroke(App *app, float mouse_x, float mouse_y, bool use_background
             if (!SDL_SetTextureBlendMode(app->blur_source_texture, SDL_BLENDMODE_NONE)) {
                 SDL_Log("Failed to set blend mode for preview restore: %s", SDL_GetError());
             }
-            if (!SDL_RenderTexture(app->ren, app->blur_source_texture, NULL, NULL)) {
+            if (!app_render_canvas_layer(app, app->blur_source_texture)) {
                 SDL_Log("Failed to restore stroke buffer for preview: %s", SDL_GetError());
             }
             if (!SDL_SetTextureBlendMode(app->blur_source_texture, SDL_BLENDMODE_BLEND)) {
@@ -110,8 +336,7 @@ void app_draw_stroke(App *app, float mouse_x, float mouse_y, bool use_background
         float y0 = app->last_stroke_y;
         float x1 = mouse_x;
         float y1 = mouse_y;
-        const bool *keyboard_state = SDL_GetKeyboardState(NULL);
-        if (keyboard_state[SDL_SCANCODE_LSHIFT] || keyboard_state[SDL_SCANCODE_RSHIFT]) {
+        if (app->held_modifiers & SDL_KMOD_SHIFT) {
             float dx = SDL_fabsf(x1 - x0);
             float dy = SDL_fabsf(y1 - y0);
             if (dx > dy) {
@@ -139,10 +364,14 @@ void app_draw_stroke(App *app, float mouse_x, float mouse_y, bool use_background
                 break;
         }
 
-        if (!SDL_SetRenderTarget(app->ren, NULL)) {
+        if (!perf_set_render_target(app->ren, NULL)) {
             SDL_Log("Failed to reset render target after preview: %s", SDL_GetError());
         }
-        app->needs_redraw = true;
+
+        // Redraw where the previous preview was as well as where the new one is.
+        app_damage_rect(app, &app->line_preview_rect);
+        app->line_preview_rect = segment_bounds(x0, y0, x1, y1, app_dab_half_extent(app, false));
+        app_damage_rect(app, &app->line_preview_rect);
         return;
     }
 
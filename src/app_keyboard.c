@@ -1,7 +1,27 @@
 #include "app.h"
 
+// The held_modifiers bit a Ctrl or Shift key stands for, or SDL_KMOD_NONE.
+static SDL_Keymod held_modifier_for_key(SDL_Keycode key)
+{
+    switch (key) {
+        case SDLK_LCTRL:
+            return SDL_KMOD_LCTRL;
+        case SDLK_RCTRL:
+            return SDL_KMOD_RCTRL;
+        case SDLK_LSHIFT:
+            return SDL_KMOD_LSHIFT;
+        case SDLK_RSHIFT:
+            return SDL_KMOD_RSHIFT;
+        default:
+            return SDL_KMOD_NONE;
+    }
+}
+
 void app_handle_keydown(App *app, const SDL_KeyboardEvent *key_event)
 {
+    SDL_Keymod held_before = app->held_modifiers;
+    app->held_modifiers |= held_modifier_for_key(key_event->key);
+
     // Handle specific keys that are not modifiers for other actions.
     switch (key_event->key) {
         case SDLK_ESCAPE:
@@ -10,13 +30,12 @@ void app_handle_keydown(App *app, const SDL_KeyboardEvent *key_event)
         case SDLK_LCTRL:
         case SDLK_RCTRL:
             if (key_event->repeat == 0) {
-                const bool *state = SDL_GetKeyboardState(NULL);
                 // Toggle on press of the *second* control key.
-                if ((key_event->key == SDLK_LCTRL && state[SDL_SCANCODE_RCTRL]) ||
-                    (key_event->key == SDLK_RCTRL && state[SDL_SCANCODE_LCTRL])) {
+                if ((key_event->key == SDLK_LCTRL && (held_before & SDL_KMOD_RCTRL)) ||
+                    (key_event->key == SDLK_RCTRL && (held_before & SDL_KMOD_LCTRL))) {
                     app_toggle_line_mode(app);
                 } else {
-                    app->needs_redraw = true; // Redraw to show toggle highlight
+                    app_damage_ui(app); // Redraw to show toggle highlight
                 }
             }
             break;
@@ -34,26 +53,26 @@ void app_handle_keydown(App *app, const SDL_KeyboardEvent *key_event)
             if (app->current_tool == TOOL_BRUSH || app->current_tool == TOOL_WATER_MARKER) {
                 app->last_color_tool = app->current_tool;
             }
-            app->needs_redraw = true;
+            app_damage_tool_change(app);
             break;
         }
         case SDLK_0:
             app->current_tool = TOOL_EMOJI;
-            app->needs_redraw = true;
+            app_damage_tool_change(app);
             break;
         case SDLK_1:
             app->current_tool = TOOL_BRUSH;
             app->last_color_tool = TOOL_BRUSH;
-            app->needs_redraw = true;
+            app_damage_tool_change(app);
             break;
         case SDLK_2:
             app->current_tool = TOOL_WATER_MARKER;
             app->last_color_tool = TOOL_WATER_MARKER;
-            app->needs_redraw = true;
+            app_damage_tool_change(app);
             break;
         case SDLK_3:
             app->current_tool = TOOL_BLUR;
-            app->needs_redraw = true;
+            app_damage_tool_change(app);
             break;
         case SDLK_F1:
             app_toggle_color_palette(app);
@@ -61,6 +80,11 @@ void app_handle_keydown(App *app, const SDL_KeyboardEvent *key_event)
         case SDLK_F2:
             app_toggle_emoji_palette(app);
             break;
+        case SDLK_F3:
+            if (perf_hud_toggle()) {
+                app->needs_redraw = true;
+            }
+            break;
         case SDLK_UP:
         case SDLK_DOWN:
         case SDLK_LEFT:
@@ -70,6 +94,21 @@ void app_handle_keydown(App *app, const SDL_KeyboardEvent *key_event)
         case SDLK_F:
             app_toggle_fullscreen(app);
             break;
+        case SDLK_Z:
+            // Ctrl+Z undoes, Ctrl+Shift+Z redoes
+            if (key_event->mod & SDL_KMOD_CTRL) {
+                if (key_event->mod & SDL_KMOD_SHIFT) {
+                    app_redo(app);
+                } else {
+                    app_undo(app);
+                }
+            }
+            break;
+        case SDLK_Y:
+            if (key_event->mod & SDL_KMOD_CTRL) {
+                app_redo(app);
+            }
+            break;
         default:
             // For other keys, try to see if they are for brush size.
             app_set_brush_radius_from_key(app, key_event->key);
@@ -79,15 +118,26 @@ void app_handle_keydown(App *app, const SDL_KeyboardEvent *key_event)
 
 void app_handle_keyup(App *app, const SDL_KeyboardEvent *key_event)
 {
+    app->held_modifiers &= ~held_modifier_for_key(key_event->key);
+
     switch (key_event->key) {
         case SDLK_LCTRL:
         case SDLK_RCTRL:
             // When a ctrl key is released, the line toggle button might change state
             // (if it was only highlighted due to the key being held).
-            app->needs_redraw = true;
+            app_damage_ui(app);
             break;
         default:
             // Other keys do not affect visual state on release.
             break;
     }
 }
+
+// Keys released while the window is unfocused send no key-up event to the app.
+void app_handle_focus_lost(App *app)
+{
+    if (app->held_modifiers != SDL_KMOD_NONE) {
+        app->held_modifiers = SDL_KMOD_NONE;
+        app_damage_ui(app);
+    }
+}
@@ -24,6 +24,7 @@ void app_recalculate_sizes_and_limits(App *app)
     if (app->brush_radius < MIN_BRUSH_SIZE) {
         app->brush_radius = MIN_BRUSH_SIZE;
     }
+    app_update_brush_spans(app);
 }
 
 void app_update_canvas_display_height(App *app)
@@ -76,7 +76,7 @@ static bool handle_palette_mousewheel(App *app, float mx, float my, int yscroll)
         return false;
     }
 
-    app->needs_redraw = true;
+    app_damage_ui(app);
     return true;
 }
 
@@ -98,14 +98,14 @@ void app_handle_mousedown(App *app, const SDL_MouseButtonEvent *mouse_event)
             if (hit_tool == TOOL_BRUSH) {
                 app->current_tool = TOOL_BRUSH;
                 app->last_color_tool = TOOL_BRUSH;
-                app->needs_redraw = true;
+                app_damage_tool_change(app);
             } else if (hit_tool == TOOL_WATER_MARKER) {
                 app->current_tool = TOOL_WATER_MARKER;
                 app->last_color_tool = TOOL_WATER_MARKER;
-                app->needs_redraw = true;
+                app_damage_tool_change(app);
             } else if (hit_tool == TOOL_BLUR) {
                 app->current_tool = TOOL_BLUR;
-                app->needs_redraw = true;
+                app_damage_tool_change(app);
             } else if (hit_tool == HIT_TEST_COLOR_PALETTE_TOGGLE) {
                 app_toggle_color_palette(app);
             } else if (hit_tool == HIT_TEST_LINE_MODE_TOGGLE) {
@@ -147,6 +147,8 @@ void app_handle_mousedown(App *app, const SDL_MouseButtonEvent *mouse_event)
             app->is_drawing = true;
             app->last_stroke_x = mx;
             app->last_stroke_y = my;
+            stroke_reset(&app->stroke);
+            app_reset_prediction(app);
             app->has_moved_since_mousedown = false;
 
             // Latch the straight-line mode for the duration of this stroke.
@@ -179,17 +181,22 @@ void app_handle_mousedown(App *app, const SDL_MouseButtonEvent *mouse_event)
 
 void app_handle_mouseup(App *app, const SDL_MouseButtonEvent *mouse_event)
 {
+    // Finish drawing the queued motion before the stroke buffer is composited or cleared.
+    app_flush_input(app);
+
     if (app->is_drawing && mouse_event->button == SDL_BUTTON_LEFT) {
         if (app->straight_line_stroke_latched) {
+            // The committed line covers exactly what its last preview did.
+            canvas_tiles_mark_rect(&app->canvas_tiles, &app->line_preview_rect, CANVAS_TILE_READBACK);
             if (app->current_tool == TOOL_BRUSH || app->current_tool == TOOL_EMOJI) {
-                if (SDL_SetRenderTarget(app->ren, app->canvas_texture)) {
+                if (perf_set_render_target(app->ren, app->canvas_texture)) {
                     if (!SDL_SetTextureBlendMode(app->stroke_buffer, SDL_BLENDMODE_BLEND)) {
                         SDL_Log("MUP:Failed to set blend mode for stroke buffer: %s", SDL_GetError());
                     }
-                    if (!SDL_RenderTexture(app->ren, app->stroke_buffer, NULL, NULL)) {
+                    if (!app_render_canvas_layer(app, app->stroke_buffer)) {
                         SDL_Log("MUP:Failed to render stroke buffer: %s", SDL_GetError());
                     }
-                    if (!SDL_SetRenderTarget(app->ren, NULL)) {
+                    if (!perf_set_render_target(app->ren, NULL)) {
                         SDL_Log("MUP:Failed to reset render target: %s", SDL_GetError());
                     }
                 } else {
@@ -208,12 +215,7 @@ void app_handle_mouseup(App *app, const SDL_MouseButtonEvent *mouse_event)
                         tool_water_marker_end_stroke(app);
                         break;
                     case TOOL_BLUR:
-                        if (!app->has_moved_since_mousedown) {
-                            // Single click: apply more dabs to make it feel substantial
-                            for (int i = 0; i < 9; ++i) {
-                                tool_blur_draw_dab(app, (int)mouse_event->x, (int)mouse_event->y);
-                            }
-                        }
+                        // A single dab is already a full-strength blur, even for a plain click.
                         tool_blur_end_stroke(app);
                         break;
                     default:
@@ -227,7 +229,7 @@ void app_handle_mouseup(App *app, const SDL_MouseButtonEvent *mouse_event)
 
     // Clear the stroke buffer for the next operation
     if (app->stroke_buffer) {
-        if (SDL_SetRenderTarget(app->ren, app->stroke_buffer)) {
+        if (perf_set_render_target(app->ren, app->stroke_buffer)) {
             if (!SDL_SetRenderDrawBlendMode(app->ren, SDL_BLENDMODE_NONE)) {
                 SDL_Log("MUP:Failed to set blend mode for clear: %s", SDL_GetError());
             }
@@ -237,7 +239,7 @@ void app_handle_mouseup(App *app, const SDL_MouseButtonEvent *mouse_event)
             if (!SDL_RenderClear(app->ren)) {
                 SDL_Log("MUP:Failed to clear stroke buffer: %s", SDL_GetError());
             }
-            if (!SDL_SetRenderTarget(app->ren, NULL)) {
+            if (!perf_set_render_target(app->ren, NULL)) {
                 SDL_Log("MUP:Failed to reset render target after clear: %s", SDL_GetError());
             }
         } else {
@@ -245,13 +247,18 @@ void app_handle_mouseup(App *app, const SDL_MouseButtonEvent *mouse_event)
         }
     }
 
+    app_sync_canvas_tiles(app);
+
     // Reset drawing state on any button release
     app->is_drawing = false;
     app->straight_line_stroke_latched = false;
     app->is_buffered_stroke_active = false;
     app->last_stroke_x = -1.0f;
     app->last_stroke_y = -1.0f;
+    stroke_reset(&app->stroke);
+    app_reset_prediction(app); // The stroke buffer was just cleared, tip included
     app->has_moved_since_mousedown = false;
+    SDL_zero(app->line_preview_rect);
     app->needs_redraw = true;
 }
 
@@ -28,7 +28,7 @@ void app_select_palette_tool(App *app, int flat_idx)
             app->brush_selected_palette_idx = flat_idx;
         }
     }
-    app->needs_redraw = true;
+    app_damage_ui(app);
 }
 
 /* ------------ Palette Navigation ------------ */
@@ -169,7 +169,7 @@ void app_move_palette_selection(App *app, SDL_Keycode key)
         app->current_color = palette_get_color(app->palette, new_idx);
     }
 
-    app->needs_redraw = true;
+    app_damage_ui(app);
 }
 
 int app_get_current_palette_selection(App *app)
@@ -189,3 +189,14 @@ int app_get_current_palette_selection(App *app)
             return app->brush_selected_palette_idx;
     }
 }
+
+// Picks up emoji glyphs finished in the background and redraws the cells waiting for them.
+void app_collect_emoji_glyphs(App *app)
+{
+    if (!app || !app->palette) {
+        return;
+    }
+    if (emoji_renderer_pump(app->palette->emoji_renderer_instance) > 0) {
+        app_damage_ui(app);
+    }
+}
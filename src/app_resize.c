@@ -14,59 +14,76 @@ void app_notify_resize_event(App *app, int new_w, int new_h)
     app->needs_redraw = true;
 }
 
-void app_process_debounced_resize(App *app)
+// Lays the palette and canvas out for app->window_w x app->window_h.
+static void app_apply_resize(App *app)
 {
-    if (app->resize_pending &&
-        (SDL_GetTicks() - app->last_resize_timestamp >= RESIZE_DEBOUNCE_MS)) {
-        // Before palette is recreated, check for special cases to preserve them.
-        bool brush_was_top_left = (app->brush_selected_palette_idx == 0);
-        bool water_marker_was_top_left = (app->water_marker_selected_palette_idx == 0);
-        bool water_marker_was_bottom_right = false;
-        if (app->palette->total_color_cells > 0) {
-            water_marker_was_bottom_right =
-                (app->water_marker_selected_palette_idx == app->palette->total_color_cells - 1);
-        }
+    // Before palette is recreated, check for special cases to preserve them.
+    bool brush_was_top_left = (app->brush_selected_palette_idx == 0);
+    bool water_marker_was_top_left = (app->water_marker_selected_palette_idx == 0);
+    bool water_marker_was_bottom_right = false;
+    if (app->palette->total_color_cells > 0) {
+        water_marker_was_bottom_right =
+            (app->water_marker_selected_palette_idx == app->palette->total_color_cells - 1);
+    }
 
-        // 1. Recreate palette: recalculates rows, columns, colors, and shuffles emojis
-        palette_recreate(app->palette, app->window_w, app->window_h);
+    // 1. Recreate palette: recalculates rows, columns, colors, and shuffles emojis
+    palette_recreate(app->palette, app->window_w, app->window_h);
 
-        // 2. Update canvas display height based on new window height and new palette layout
-        app_update_canvas_display_height(app);
+    // 2. Update canvas display height based on new window height and new palette layout
+    app_update_canvas_display_height(app);
 
-        // 3. Reset selections and colors, preserving special cases.
-        // Brush: stays top-left if it was, otherwise defaults to bottom-right.
-        if (brush_was_top_left) {
-            app->brush_selected_palette_idx = 0;
-        } else {
-            app->brush_selected_palette_idx =
-                app->palette->total_color_cells > 0 ? app->palette->total_color_cells - 1 : 0;
-        }
+    // 3. Reset selections and colors, preserving special cases.
+    // Brush: stays top-left if it was, otherwise defaults to bottom-right.
+    if (brush_was_top_left) {
+        app->brush_selected_palette_idx = 0;
+    } else {
+        app->brush_selected_palette_idx =
+            app->palette->total_color_cells > 0 ? app->palette->total_color_cells - 1 : 0;
+    }
 
-        // Water-marker: stays top-left or bottom-right if it was, otherwise defaults to
-        // top-left.
-        if (water_marker_was_top_left) {
-            app->water_marker_selected_palette_idx = 0;
-        } else if (water_marker_was_bottom_right) {
-            app->water_marker_selected_palette_idx =
-                app->palette->total_color_cells > 0 ? app->palette->total_color_cells - 1 : 0;
-        } else {
-            app->water_marker_selected_palette_idx = 0; // Default to top-left
-        }
+    // Water-marker: stays top-left or bottom-right if it was, otherwise defaults to
+    // top-left.
+    if (water_marker_was_top_left) {
+        app->water_marker_selected_palette_idx = 0;
+    } else if (water_marker_was_bottom_right) {
+        app->water_marker_selected_palette_idx =
+            app->palette->total_color_cells > 0 ? app->palette->total_color_cells - 1 : 0;
+    } else {
+        app->water_marker_selected_palette_idx = 0; // Default to top-left
+    }
+
+    // Update colors from new palette
+    app->current_color = palette_get_color(app->palette, app->brush_selected_palette_idx);
+    app->water_marker_color =
+        palette_get_color(app->palette, app->water_marker_selected_palette_idx);
 
-        // Update colors from new palette
-        app->current_color = palette_get_color(app->palette, app->brush_selected_palette_idx);
-        app->water_marker_color =
-            palette_get_color(app->palette, app->water_marker_selected_palette_idx);
+    app->emoji_selected_palette_idx = app->palette->total_color_cells;
 
-        app->emoji_selected_palette_idx = app->palette->total_color_cells;
+    // 4. Recalculate brush size limits based on new layout
+    app_recalculate_sizes_and_limits(app);
 
-        // 4. Recalculate brush size limits based on new layout
-        app_recalculate_sizes_and_limits(app);
+    // 5. Resize the canvas texture, preserving the old content
+    app_recreate_canvas_texture(app);
 
-        // 5. Create a new canvas texture, preserving the old content
-        app_recreate_canvas_texture(app);
+    app->resize_pending = false;
+    app->needs_redraw = true;
+}
 
-        app->resize_pending = false;
-        app->needs_redraw = true;
+void app_process_debounced_resize(App *app)
+{
+    if (app->resize_pending &&
+        (SDL_GetTicks() - app->last_resize_timestamp >= RESIZE_DEBOUNCE_MS)) {
+        app_apply_resize(app);
+    }
+}
+
+bool app_apply_resize_now(App *app, int new_w, int new_h)
+{
+    if (!SDL_SetWindowSize(app->win, new_w, new_h)) {
+        SDL_Log("Failed to resize window to %dx%d: %s", new_w, new_h, SDL_GetError());
+        return false;
     }
+    app_notify_resize_event(app, new_w, new_h);
+    app_apply_resize(app);
+    return true;
 }
@@ -8,7 +8,7 @@ void app_toggle_line_mode(App *app)
         return;
     }
     app->line_mode_toggled_on = !app->line_mode_toggled_on;
-    app->needs_redraw = true;
+    app_damage_ui(app);
 }
 
 bool app_is_straight_line_mode(const App *app)
@@ -16,9 +16,7 @@ bool app_is_straight_line_mode(const App *app)
     if (!app || app->current_tool == TOOL_BLUR) {
         return false;
     }
-    const bool *keyboard_state = SDL_GetKeyboardState(NULL);
-    return app->line_mode_toggled_on || keyboard_state[SDL_SCANCODE_LCTRL] ||
-           keyboard_state[SDL_SCANCODE_RCTRL];
+    return app->line_mode_toggled_on || (app->held_modifiers & SDL_KMOD_CTRL) != 0;
 }
 
 void app_toggle_fullscreen(App *app)
@@ -0,0 +1,226 @@
+#include "blur.h"
+
+#define BLUR_BOX_PASSES 3
+
+// Radii of the box blurs whose combination best matches a Gaussian of sigma.
+// See Kovesi, "Fast Almost-Gaussian Filtering" (2010).
+static void blur_box_radii(float sigma, int radii[BLUR_BOX_PASSES])
+{
+    const float n = (float)BLUR_BOX_PASSES;
+    float w_ideal = SDL_sqrtf(12.0f * sigma * sigma / n + 1.0f);
+    int wl = (int)SDL_floorf(w_ideal);
+    if (wl % 2 == 0) {
+        --wl;
+    }
+    int wu = wl + 2;
+    float m_ideal =
+        (12.0f * sigma * sigma - n * wl * wl - 4.0f * n * wl - 3.0f * n) / (-4.0f * wl - 4.0f);
+    int m = (int)SDL_roundf(m_ideal);
+    for (int i = 0; i < BLUR_BOX_PASSES; ++i) {
+        radii[i] = ((i < m ? wl : wu) - 1) / 2;
+    }
+}
+
+int blur_gaussian_reach(float sigma)
+{
+    int radii[BLUR_BOX_PASSES];
+    blur_box_radii(sigma, radii);
+    int reach = 0;
+    for (int i = 0; i < BLUR_BOX_PASSES; ++i) {
+        reach += radii[i];
+    }
+    return reach;
+}
+
+// Horizontal box blur of radius r. Each channel keeps a running sum along the row.
+static void box_blur_h(const Uint8 *src, Uint8 *dst, int w, int h, int pitch, int r)
+{
+    const int inv = 65536 / (2 * r + 1);
+    for (int y = 0; y < h; ++y) {
+        const Uint8 *s = src + (size_t)y * pitch;
+        Uint8 *d = dst + (size_t)y * pitch;
+        for (int c = 0; c < 4; ++c) {
+            // Window [x - r, x + r] with edges clamped; start with [-r, r - 1].
+            int sum = r * s[c];
+            for (int i = 0; i < r; ++i) {
+                sum += s[SDL_min(i, w - 1) * 4 + c];
+            }
+            for (int x = 0; x < w; ++x) {
+                sum += s[SDL_min(x + r, w - 1) * 4 + c];
+                d[x * 4 + c] = (Uint8)((sum * inv + 32768) >> 16);
+                sum -= s[SDL_max(x - r, 0) * 4 + c];
+            }
+        }
+    }
+}
+
+// Vertical box blur of radius r. Whole rows are added and subtracted at once,
+// so the inner loops are plain element-wise array arithmetic the compiler vectorizes.
+static void box_blur_v(const Uint8 *src, Uint8 *dst, int w, int h, int pitch, int r, int *restrict acc)
+{
+    const int n = w * 4;
+    const int inv = 65536 / (2 * r + 1);
+
+    for (int i = 0; i < n; ++i) {
+        acc[i] = r * src[i];
+    }
+    for (int k = 0; k < r; ++k) {
+        const Uint8 *restrict row = src + (size_t)SDL_min(k, h - 1) * pitch;
+        for (int i = 0; i < n; ++i) {
+            acc[i] += row[i];
+        }
+    }
+
+    for (int y = 0; y < h; ++y) {
+        const Uint8 *restrict add = src + (size_t)SDL_min(y + r, h - 1) * pitch;
+        const Uint8 *restrict sub = src + (size_t)SDL_max(y - r, 0) * pitch;
+        Uint8 *restrict d = dst + (size_t)y * pitch;
+        for (int i = 0; i < n; ++i) {
+            acc[i] += add[i];
+            d[i] = (Uint8)((acc[i] * inv + 32768) >> 16);
+            acc[i] -= sub[i];
+        }
+    }
+}
+
+bool blur_gaussian_rgba(Uint8 *pixels, int w, int h, int pitch, float sigma)
+{
+    if (w <= 0 || h <= 0) {
+        return true;
+    }
+
+    Uint8 *temp = SDL_malloc((size_t)h * pitch);
+    int *acc = SDL_malloc(sizeof(int) * w * 4);
+    if (!temp || !acc) {
+        SDL_Log("Blur: Failed to allocate scratch for %dx%d", w, h);
+        SDL_free(temp);
+        SDL_free(acc);
+        return false;
+    }
+
+    int radii[BLUR_BOX_PASSES];
+    blur_box_radii(sigma, radii);
+    for (int i = 0; i < BLUR_BOX_PASSES; ++i) {
+        if (radii[i] <= 0) {
+            continue;
+        }
+        box_blur_h(pixels, temp, w, h, pitch, radii[i]);
+        box_blur_v(temp, pixels, w, h, pitch, radii[i], acc);
+    }
+
+    SDL_free(temp);
+    SDL_free(acc);
+    return true;
+}
+
+static void rect_add(SDL_Rect *bounds, const SDL_Rect *r)
+{
+    if (SDL_RectEmpty(bounds)) {
+        *bounds = *r;
+    } else {
+        SDL_GetRectUnion(bounds, r, bounds);
+    }
+}
+
+bool blur_mask_begin(BlurMask *m, int w, int h)
+{
+    if (w * h > m->w * m->h || !m->coverage) {
+        Uint8 *coverage = SDL_realloc(m->coverage, (size_t)w * h);
+        if (!coverage) {
+            SDL_Log("Blur: Failed to allocate %dx%d stroke mask", w, h);
+            return false;
+        }
+        m->coverage = coverage;
+    }
+    m->w = w;
+    m->h = h;
+    SDL_memset(m->coverage, 0, (size_t)w * h);
+    SDL_zero(m->used);
+    SDL_zero(m->pending);
+    return true;
+}
+
+void blur_mask_free(BlurMask *m)
+{
+    if (!m) {
+        return;
+    }
+    SDL_free(m->coverage);
+    SDL_zerop(m);
+}
+
+void blur_mask_clear(BlurMask *m)
+{
+    if (SDL_RectEmpty(&m->used)) {
+        return;
+    }
+    for (int y = m->used.y; y < m->used.y + m->used.h; ++y) {
+        SDL_memset(&m->coverage[(size_t)y * m->w + m->used.x], 0, m->used.w);
+    }
+    rect_add(&m->pending, &m->used);
+    SDL_zero(m->used);
+}
+
+void blur_mask_stamp_segment(BlurMask *m, float x0, float y0, float x1, float y1, float radius)
+{
+    if (!m->coverage || radius <= 0.0f) {
+        return;
+    }
+
+    SDL_Rect bounds = {
+        (int)SDL_floorf(SDL_min(x0, x1) - radius),
+        (int)SDL_floorf(SDL_min(y0, y1) - radius),
+        (int)SDL_ceilf(SDL_fabsf(x1 - x0) + 2.0f * radius) + 2,
+        (int)SDL_ceilf(SDL_fabsf(y1 - y0) + 2.0f * radius) + 2,
+    };
+    SDL_Rect mask_rect = {0, 0, m->w, m->h};
+    if (!SDL_GetRectIntersection(&bounds, &mask_rect, &bounds)) {
+        return;
+    }
+
+    // Distance from each pixel centre to the segment, as a fraction of the radius.
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const float len_sq = dx * dx + dy * dy;
+    const float inv_len_sq = len_sq > 0.0f ? 1.0f / len_sq : 0.0f;
+    const float inv_radius = 1.0f / radius;
+    for (int y = bounds.y; y < bounds.y + bounds.h; ++y) {
+        Uint8 *row = &m->coverage[(size_t)y * m->w];
+        const float py = (float)y + 0.5f - y0;
+        for (int x = bounds.x; x < bounds.x + bounds.w; ++x) {
+            const float px = (float)x + 0.5f - x0;
+            float t = SDL_clamp((px * dx + py * dy) * inv_len_sq, 0.0f, 1.0f);
+            float ex = px - t * dx;
+            float ey = py - t * dy;
+            float c = 1.0f - SDL_sqrtf(ex * ex + ey * ey) * inv_radius;
+            if (c > 0.0f) {
+                Uint8 v = (Uint8)(c * 255.0f + 0.5f);
+                row[x] = SDL_max(row[x], v);
+            }
+        }
+    }
+
+    rect_add(&m->used, &bounds);
+    rect_add(&m->pending, &bounds);
+}
+
+SDL_Rect blur_mask_take_pending(BlurMask *m)
+{
+    SDL_Rect r = m->pending;
+    SDL_zero(m->pending);
+    return r;
+}
+
+void blur_mask_apply(const BlurMask *m, const SDL_Rect *rect,
+                     const Uint32 *original, Uint32 *blurred, int ox, int oy, int pitch)
+{
+    for (int y = rect->y; y < rect->y + rect->h; ++y) {
+        const Uint8 *restrict cov = &m->coverage[(size_t)y * m->w + rect->x];
+        const Uint8 *restrict src = (const Uint8 *)&original[(size_t)(y - oy) * pitch + (rect->x - ox)];
+        Uint8 *restrict dst = (Uint8 *)&blurred[(size_t)(y - oy) * pitch + (rect->x - ox)];
+        for (int i = 0; i < rect->w * 4; ++i) {
+            int a = cov[i / 4];
+            dst[i] = (Uint8)(src[i] + ((dst[i] - src[i]) * a + 127) / 255);
+        }
+    }
+}
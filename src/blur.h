@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+ * Blurs a w x h block of 4-channel, 8-bit pixels in place with an approximate
+ * Gaussian of the given sigma: three successive box blurs, each separated into
+ * a horizontal and a vertical pass. The cost per pixel does not depend on sigma.
+ * Edges are clamped. The channel order does not matter; all four are treated alike.
+ *
+ * Returns false if the scratch buffers cannot be allocated.
+ */
+bool blur_gaussian_rgba(Uint8 *pixels, int w, int h, int pitch, float sigma);
+
+// How far, in pixels, a blur of the given sigma reaches from each output pixel.
+int blur_gaussian_reach(float sigma);
+
+/*
+ * Per-pixel coverage of a blur stroke. The stroke footprint is accumulated here
+ * and blurred once per frame over the area that changed, instead of blurring
+ * every dab separately.
+ */
+typedef struct BlurMask {
+    Uint8 *coverage; // w * h; 0 keeps the original pixel, 255 takes the blurred one
+    int w;
+    int h;
+    SDL_Rect used;    // Bounds of all nonzero coverage
+    SDL_Rect pending; // Bounds of coverage changed since blur_mask_take_pending
+} BlurMask;
+
+// Prepares an all-zero mask of the given size, reusing the allocation when it fits.
+bool blur_mask_begin(BlurMask *m, int w, int h);
+void blur_mask_free(BlurMask *m);
+
+// Zeroes all coverage; the cleared area becomes pending.
+void blur_mask_clear(BlurMask *m);
+
+// Adds a capsule of the given radius around the segment. Coverage falls off
+// linearly from the centre line to the edge; overlapping stamps keep the maximum.
+void blur_mask_stamp_segment(BlurMask *m, float x0, float y0, float x1, float y1, float radius);
+
+// Returns the pending rect and resets it.
+SDL_Rect blur_mask_take_pending(BlurMask *m);
+
+// Blends the blurred pixels over the original ones by coverage, for rect (in mask
+// coordinates). Both buffers hold the area starting at (ox, oy) with the given pitch
+// in pixels; the result is written into blurred.
+void blur_mask_apply(const BlurMask *m, const SDL_Rect *rect,
+                     const Uint32 *original, Uint32 *blurred, int ox, int oy, int pitch);
@@ -0,0 +1,419 @@
+#include "canvas_tiles.h"
+#include "perf_hud.h"
+
+static Uint32 map_color(SDL_Color c)
+{
+    return SDL_MapRGBA(SDL_GetPixelFormatDetails(CANVAS_TILE_FORMAT), NULL, c.r, c.g, c.b, c.a);
+}
+
+CanvasTile *canvas_tile_retain(CanvasTile *tile)
+{
+    if (tile) {
+        ++tile->refcount;
+    }
+    return tile;
+}
+
+void canvas_tile_release(CanvasTile *tile)
+{
+    if (tile && --tile->refcount == 0) {
+        SDL_free(tile);
+    }
+}
+
+bool canvas_tiles_init(CanvasTiles *ct, int w, int h, SDL_Color clear_color)
+{
+    SDL_zerop(ct);
+    ct->w = w;
+    ct->h = h;
+    ct->tiles_x = (w + CANVAS_TILE_SIZE - 1) / CANVAS_TILE_SIZE;
+    ct->tiles_y = (h + CANVAS_TILE_SIZE - 1) / CANVAS_TILE_SIZE;
+    ct->clear_color = clear_color;
+    ct->clear_pixel = map_color(clear_color);
+
+    int count = ct->tiles_x * ct->tiles_y;
+    if (count == 0) {
+        return true;
+    }
+    ct->tiles = SDL_calloc(count, sizeof(*ct->tiles));
+    ct->flags = SDL_calloc(count, sizeof(*ct->flags));
+    ct->snapshot = SDL_calloc(count, sizeof(*ct->snapshot));
+    if (!ct->tiles || !ct->flags || !ct->snapshot) {
+        SDL_Log("CanvasTiles: Failed to allocate %d tiles", count);
+        canvas_tiles_free(ct);
+        return false;
+    }
+    return true;
+}
+
+void canvas_tiles_free(CanvasTiles *ct)
+{
+    if (!ct) {
+        return;
+    }
+    if (ct->tiles) {
+        for (int i = 0; i < ct->tiles_x * ct->tiles_y; ++i) {
+            canvas_tile_release(ct->tiles[i]);
+        }
+    }
+    if (ct->flags && ct->snapshot) {
+        canvas_tiles_forget_snapshots(ct);
+    }
+    SDL_free(ct->tiles);
+    SDL_free(ct->flags);
+    SDL_free(ct->snapshot);
+    SDL_zerop(ct);
+}
+
+void canvas_tiles_clear(CanvasTiles *ct, SDL_Color clear_color)
+{
+    int count = ct->tiles_x * ct->tiles_y;
+    canvas_tiles_forget_snapshots(ct);
+    for (int i = 0; i < count; ++i) {
+        canvas_tile_release(ct->tiles[i]);
+        ct->tiles[i] = NULL;
+        ct->flags[i] = 0;
+    }
+    ct->clear_color = clear_color;
+    ct->clear_pixel = map_color(clear_color);
+}
+
+void canvas_tiles_set_clear_color(CanvasTiles *ct, SDL_Color clear_color)
+{
+    Uint32 pixel = map_color(clear_color);
+    ct->clear_color = clear_color;
+    if (pixel == ct->clear_pixel) {
+        return;
+    }
+    ct->clear_pixel = pixel;
+    for (int i = 0; i < ct->tiles_x * ct->tiles_y; ++i) {
+        if (!ct->tiles[i]) {
+            ct->flags[i] |= CANVAS_TILE_UPLOAD;
+        }
+    }
+}
+
+void canvas_tiles_set_tile(CanvasTiles *ct, int tile_idx, CanvasTile *tile)
+{
+    canvas_tile_retain(tile);
+    canvas_tile_release(ct->tiles[tile_idx]);
+    ct->tiles[tile_idx] = tile;
+    ct->flags[tile_idx] |= CANVAS_TILE_UPLOAD;
+}
+
+void canvas_tiles_mark_rect(CanvasTiles *ct, const SDL_Rect *rect, Uint8 flag)
+{
+    SDL_Rect bounds = {0, 0, ct->w, ct->h};
+    SDL_Rect r;
+    if (!SDL_GetRectIntersection(rect, &bounds, &r)) {
+        return;
+    }
+    int tx0 = r.x / CANVAS_TILE_SIZE;
+    int ty0 = r.y / CANVAS_TILE_SIZE;
+    int tx1 = (r.x + r.w - 1) / CANVAS_TILE_SIZE;
+    int ty1 = (r.y + r.h - 1) / CANVAS_TILE_SIZE;
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            ct->flags[ty * ct->tiles_x + tx] |= flag;
+        }
+    }
+}
+
+SDL_Rect canvas_tiles_tile_rect(const CanvasTiles *ct, int tile_idx)
+{
+    SDL_Rect r = {
+        (tile_idx % ct->tiles_x) * CANVAS_TILE_SIZE,
+        (tile_idx / ct->tiles_x) * CANVAS_TILE_SIZE,
+        CANVAS_TILE_SIZE,
+        CANVAS_TILE_SIZE,
+    };
+    r.w = SDL_min(r.w, ct->w - r.x);
+    r.h = SDL_min(r.h, ct->h - r.y);
+    return r;
+}
+
+// Returns a tile that may be written to: shared tiles are immutable, so those are
+// replaced by a fresh one. With keep_contents the old pixels are carried over;
+// otherwise a fresh tile starts out as the clear color, so the part of an edge
+// tile outside the canvas is never left uninitialized.
+static CanvasTile *canvas_tiles_writable_tile(CanvasTiles *ct, int tile_idx, bool keep_contents)
+{
+    CanvasTile *old = ct->tiles[tile_idx];
+    if (old && old->refcount == 1) {
+        return old;
+    }
+
+    CanvasTile *tile = SDL_malloc(sizeof(*tile));
+    if (!tile) {
+        SDL_Log("CanvasTiles: Failed to allocate tile %d", tile_idx);
+        return NULL;
+    }
+    tile->refcount = 1;
+    if (keep_contents && old) {
+        SDL_memcpy(tile->pixels, old->pixels, sizeof(tile->pixels));
+    } else {
+        for (int p = 0; p < CANVAS_TILE_PIXELS; ++p) {
+            tile->pixels[p] = ct->clear_pixel;
+        }
+    }
+    canvas_tile_release(old);
+    ct->tiles[tile_idx] = tile;
+    return tile;
+}
+
+// Paints the pixels of a tile beyond its first valid_w x valid_h the clear color,
+// copying the tile first if it is shared. Empty tiles are the clear color already.
+static void canvas_tiles_clear_outside(CanvasTiles *ct, int tile_idx, int valid_w, int valid_h)
+{
+    SDL_Rect r = canvas_tiles_tile_rect(ct, tile_idx);
+    if (!ct->tiles[tile_idx] || (r.w <= valid_w && r.h <= valid_h)) {
+        return;
+    }
+    CanvasTile *tile = canvas_tiles_writable_tile(ct, tile_idx, true);
+    if (!tile) {
+        return;
+    }
+    for (int y = 0; y < r.h; ++y) {
+        int x0 = y < valid_h ? valid_w : 0;
+        for (int x = x0; x < r.w; ++x) {
+            tile->pixels[y * CANVAS_TILE_SIZE + x] = ct->clear_pixel;
+        }
+    }
+}
+
+void canvas_tiles_set_tile_within(CanvasTiles *ct, int tile_idx, CanvasTile *tile, int valid_w, int valid_h)
+{
+    canvas_tiles_set_tile(ct, tile_idx, tile);
+    canvas_tiles_clear_outside(ct, tile_idx, valid_w, valid_h);
+}
+
+// Keeps the tile as it is now for history, unless it was already kept since the last step.
+static void canvas_tiles_take_snapshot(CanvasTiles *ct, int tile_idx)
+{
+    if (!(ct->flags[tile_idx] & CANVAS_TILE_SNAPSHOT)) {
+        // Sharing the tile with the snapshot makes later writes go to a copy.
+        ct->snapshot[tile_idx] = canvas_tile_retain(ct->tiles[tile_idx]);
+        ct->flags[tile_idx] |= CANVAS_TILE_SNAPSHOT;
+    }
+}
+
+CanvasTile *canvas_tiles_write_tile(CanvasTiles *ct, int tile_idx)
+{
+    canvas_tiles_take_snapshot(ct, tile_idx);
+    CanvasTile *tile = canvas_tiles_writable_tile(ct, tile_idx, true);
+    if (tile) {
+        ct->flags[tile_idx] |= CANVAS_TILE_UPLOAD;
+    }
+    return tile;
+}
+
+void canvas_tiles_forget_snapshots(CanvasTiles *ct)
+{
+    for (int i = 0; i < ct->tiles_x * ct->tiles_y; ++i) {
+        if (ct->flags[i] & CANVAS_TILE_SNAPSHOT) {
+            canvas_tile_release(ct->snapshot[i]);
+            ct->snapshot[i] = NULL;
+            ct->flags[i] &= ~CANVAS_TILE_SNAPSHOT;
+        }
+    }
+}
+
+bool canvas_tiles_resize(CanvasTiles *ct, int w, int h)
+{
+    CanvasTiles resized;
+    if (!canvas_tiles_init(&resized, w, h, ct->clear_color)) {
+        return false;
+    }
+
+    int keep_x = SDL_min(ct->tiles_x, resized.tiles_x);
+    int keep_y = SDL_min(ct->tiles_y, resized.tiles_y);
+    for (int ty = 0; ty < keep_y; ++ty) {
+        for (int tx = 0; tx < keep_x; ++tx) {
+            int old_idx = ty * ct->tiles_x + tx;
+            int idx = ty * resized.tiles_x + tx;
+            SDL_Rect old_r = canvas_tiles_tile_rect(ct, old_idx);
+            resized.tiles[idx] = ct->tiles[old_idx];
+            resized.flags[idx] = ct->flags[old_idx];
+            resized.snapshot[idx] = ct->snapshot[old_idx];
+            ct->tiles[old_idx] = NULL;
+            ct->flags[old_idx] &= ~CANVAS_TILE_SNAPSHOT;
+            ct->snapshot[old_idx] = NULL;
+
+            // Pixels of an edge tile that were outside the old canvas are now background.
+            canvas_tiles_clear_outside(&resized, idx, old_r.w, old_r.h);
+        }
+    }
+
+    canvas_tiles_free(ct);
+    *ct = resized;
+    return true;
+}
+
+void canvas_tiles_read_rect(const CanvasTiles *ct, const SDL_Rect *rect, Uint32 *dst, int dst_pitch)
+{
+    for (int y = rect->y; y < rect->y + rect->h; ++y) {
+        Uint32 *out = dst + (size_t)(y - rect->y) * dst_pitch;
+        int ty = y / CANVAS_TILE_SIZE;
+        int row = y % CANVAS_TILE_SIZE;
+        int x = rect->x;
+        while (x < rect->x + rect->w) {
+            int tx = x / CANVAS_TILE_SIZE;
+            int col = x % CANVAS_TILE_SIZE;
+            int run = SDL_min(CANVAS_TILE_SIZE - col, rect->x + rect->w - x);
+            const CanvasTile *tile = ct->tiles[ty * ct->tiles_x + tx];
+            if (tile) {
+                SDL_memcpy(out, &tile->pixels[row * CANVAS_TILE_SIZE + col], run * sizeof(Uint32));
+            } else {
+                for (int i = 0; i < run; ++i) {
+                    out[i] = ct->clear_pixel;
+                }
+            }
+            out += run;
+            x += run;
+        }
+    }
+}
+
+// Copies one tile's worth of pixels out of a surface whose origin is at (ox, oy) in canvas space.
+static void copy_tile_from_surface(CanvasTiles *ct, int tile_idx, const SDL_Surface *surf, int ox, int oy)
+{
+    CanvasTile *tile = canvas_tiles_writable_tile(ct, tile_idx, false);
+    if (!tile) {
+        return;
+    }
+
+    SDL_Rect tr = canvas_tiles_tile_rect(ct, tile_idx);
+    Uint32 *dst = tile->pixels;
+    for (int y = 0; y < tr.h; ++y) {
+        const Uint8 *row = (const Uint8 *)surf->pixels + (size_t)(tr.y - oy + y) * surf->pitch;
+        SDL_memcpy(&dst[y * CANVAS_TILE_SIZE], row + (size_t)(tr.x - ox) * sizeof(Uint32),
+                   tr.w * sizeof(Uint32));
+    }
+    ct->flags[tile_idx] &= ~CANVAS_TILE_READBACK;
+}
+
+void canvas_tiles_readback(CanvasTiles *ct, SDL_Renderer *ren, SDL_Texture *canvas)
+{
+    // Read the bounding box of all pending tiles at once: every read stalls the GPU.
+    int count = ct->tiles_x * ct->tiles_y;
+    SDL_Rect bounds = {0, 0, 0, 0};
+    for (int i = 0; i < count; ++i) {
+        if (ct->flags[i] & CANVAS_TILE_READBACK) {
+            SDL_Rect tr = canvas_tiles_tile_rect(ct, i);
+            if (SDL_RectEmpty(&bounds)) {
+                bounds = tr;
+            } else {
+                SDL_GetRectUnion(&bounds, &tr, &bounds);
+            }
+        }
+    }
+    if (SDL_RectEmpty(&bounds)) {
+        return;
+    }
+
+    if (!perf_set_render_target(ren, canvas)) {
+        SDL_Log("CanvasTiles: Failed to set render target for readback: %s", SDL_GetError());
+        return;
+    }
+    SDL_Surface *surf = SDL_RenderReadPixels(ren, &bounds);
+    if (!perf_set_render_target(ren, NULL)) {
+        SDL_Log("CanvasTiles: Failed to reset render target: %s", SDL_GetError());
+    }
+    if (!surf) {
+        SDL_Log("CanvasTiles: Failed to read back canvas: %s", SDL_GetError());
+        return;
+    }
+    if (surf->format != CANVAS_TILE_FORMAT) {
+        SDL_Surface *converted = SDL_ConvertSurface(surf, CANVAS_TILE_FORMAT);
+        SDL_DestroySurface(surf);
+        if (!converted) {
+            SDL_Log("CanvasTiles: Failed to convert readback: %s", SDL_GetError());
+            return;
+        }
+        surf = converted;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (ct->flags[i] & CANVAS_TILE_READBACK) {
+            copy_tile_from_surface(ct, i, surf, bounds.x, bounds.y);
+        }
+    }
+    SDL_DestroySurface(surf);
+}
+
+void canvas_tiles_readback_for_write(CanvasTiles *ct, SDL_Renderer *ren, SDL_Texture *canvas)
+{
+    for (int i = 0; i < ct->tiles_x * ct->tiles_y; ++i) {
+        if (ct->flags[i] & CANVAS_TILE_READBACK) {
+            canvas_tiles_take_snapshot(ct, i);
+        }
+    }
+    canvas_tiles_readback(ct, ren, canvas);
+}
+
+// Uploads tile i if it is marked CANVAS_TILE_UPLOAD. Empty tiles share one scratch
+// tile filled with the clear color, allocated on first use into *clear_tile.
+// Returns false if that allocation fails.
+static bool canvas_tiles_upload_tile(CanvasTiles *ct, SDL_Texture *canvas, int i, Uint32 **clear_tile)
+{
+    if (!(ct->flags[i] & CANVAS_TILE_UPLOAD)) {
+        return true;
+    }
+
+    const Uint32 *pixels = ct->tiles[i] ? ct->tiles[i]->pixels : NULL;
+    if (!pixels) {
+        if (!*clear_tile) {
+            *clear_tile = SDL_malloc(CANVAS_TILE_PIXELS * sizeof(Uint32));
+            if (!*clear_tile) {
+                SDL_Log("CanvasTiles: Failed to allocate clear tile");
+                return false;
+            }
+            for (int p = 0; p < CANVAS_TILE_PIXELS; ++p) {
+                (*clear_tile)[p] = ct->clear_pixel;
+            }
+        }
+        pixels = *clear_tile;
+    }
+
+    SDL_Rect tr = canvas_tiles_tile_rect(ct, i);
+    if (!perf_update_texture(canvas, &tr, pixels, CANVAS_TILE_SIZE * sizeof(Uint32))) {
+        SDL_Log("CanvasTiles: Failed to upload tile %d: %s", i, SDL_GetError());
+    }
+    ct->flags[i] &= ~CANVAS_TILE_UPLOAD;
+    return true;
+}
+
+void canvas_tiles_upload(CanvasTiles *ct, SDL_Texture *canvas)
+{
+    Uint32 *clear_tile = NULL;
+    int count = ct->tiles_x * ct->tiles_y;
+    for (int i = 0; i < count; ++i) {
+        if (!canvas_tiles_upload_tile(ct, canvas, i, &clear_tile)) {
+            break;
+        }
+    }
+    SDL_free(clear_tile);
+}
+
+void canvas_tiles_upload_rect(CanvasTiles *ct, SDL_Texture *canvas, const SDL_Rect *rect)
+{
+    SDL_Rect bounds = {0, 0, ct->w, ct->h};
+    SDL_Rect r;
+    if (!SDL_GetRectIntersection(rect, &bounds, &r)) {
+        return;
+    }
+    Uint32 *clear_tile = NULL;
+    int tx0 = r.x / CANVAS_TILE_SIZE;
+    int ty0 = r.y / CANVAS_TILE_SIZE;
+    int tx1 = (r.x + r.w - 1) / CANVAS_TILE_SIZE;
+    int ty1 = (r.y + r.h - 1) / CANVAS_TILE_SIZE;
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            if (!canvas_tiles_upload_tile(ct, canvas, ty * ct->tiles_x + tx, &clear_tile)) {
+                SDL_free(clear_tile);
+                return;
+            }
+        }
+    }
+    SDL_free(clear_tile);
+}
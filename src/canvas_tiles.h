@@ -0,0 +1,101 @@
+#pragma once
+
+#define CANVAS_TILE_SIZE 64 // Tile edge in pixels
+#define CANVAS_TILE_PIXELS (CANVAS_TILE_SIZE * CANVAS_TILE_SIZE)
+#define CANVAS_TILE_FORMAT SDL_PIXELFORMAT_RGBA8888
+
+// Per-tile dirty bits.
+#define CANVAS_TILE_UPLOAD   0x01 // CPU pixels are newer than the texture
+#define CANVAS_TILE_READBACK 0x02 // Texture pixels are newer than the CPU copy
+#define CANVAS_TILE_SNAPSHOT 0x04 // Written on the CPU since the last history step; see snapshot
+
+/*
+ * CPU copy of the canvas, split into fixed-size RGBA tiles.
+ *
+ * Tools keep drawing into the GPU canvas texture; the tiles the stroke touched
+ * are read back once the stroke ends. Changes made on the CPU side are pushed
+ * to the texture tile by tile with SDL_UpdateTexture. A NULL tile holds only
+ * the clear color and costs no memory.
+ *
+ * Tiles can also be drawn into directly (see tile_raster.h). The first write
+ * to a tile after a history step keeps the old tile in snapshot, so the step
+ * can still record what the tile looked like before.
+ *
+ * Tiles are reference counted and never modified once shared, so snapshots
+ * (see history.h) can keep old tiles alive without copying them.
+ */
+typedef struct CanvasTile {
+    int refcount;
+    Uint32 pixels[CANVAS_TILE_PIXELS];
+} CanvasTile;
+
+typedef struct CanvasTiles {
+    int w;
+    int h;
+    int tiles_x;
+    int tiles_y;
+    CanvasTile **tiles;    // tiles_x * tiles_y, row-major; NULL means clear_pixel everywhere
+    Uint8 *flags;          // CANVAS_TILE_* bits per tile
+    CanvasTile **snapshot; // Tile before the first CPU write, where CANVAS_TILE_SNAPSHOT is set
+    SDL_Color clear_color;
+    Uint32 clear_pixel;
+} CanvasTiles;
+
+// Both accept NULL. Retain returns its argument for convenience.
+CanvasTile *canvas_tile_retain(CanvasTile *tile);
+void canvas_tile_release(CanvasTile *tile);
+
+bool canvas_tiles_init(CanvasTiles *ct, int w, int h, SDL_Color clear_color);
+void canvas_tiles_free(CanvasTiles *ct);
+
+// Drops every tile, as the whole canvas is now the given color.
+void canvas_tiles_clear(CanvasTiles *ct, SDL_Color clear_color);
+
+// Changes the canvas size, keeping the tiles that still fit; the newly exposed
+// area is the clear color. Shared tiles stay untouched.
+bool canvas_tiles_resize(CanvasTiles *ct, int w, int h);
+
+// Changes the color empty tiles stand for; every empty tile is queued for upload.
+void canvas_tiles_set_clear_color(CanvasTiles *ct, SDL_Color clear_color);
+
+// Replaces a tile (taking a new reference) and queues it for upload.
+void canvas_tiles_set_tile(CanvasTiles *ct, int tile_idx, CanvasTile *tile);
+
+// Like canvas_tiles_set_tile, for a tile whose pixels are only meaningful in its first
+// valid_w x valid_h (it was an edge tile of a smaller canvas): the rest of it is
+// painted the clear color.
+void canvas_tiles_set_tile_within(CanvasTiles *ct, int tile_idx, CanvasTile *tile, int valid_w, int valid_h);
+
+// Returns the tile to draw into on the CPU, queued for upload. The tile is not shared,
+// so it may be written from any thread. Returns NULL if it cannot be allocated.
+// A tile marked CANVAS_TILE_READBACK must be read back first.
+CanvasTile *canvas_tiles_write_tile(CanvasTiles *ct, int tile_idx);
+
+// Releases the snapshots of CPU-written tiles without recording them.
+void canvas_tiles_forget_snapshots(CanvasTiles *ct);
+
+// Sets flag on every tile overlapping rect.
+void canvas_tiles_mark_rect(CanvasTiles *ct, const SDL_Rect *rect, Uint8 flag);
+
+// Pixel rect covered by a tile, clipped to the canvas.
+SDL_Rect canvas_tiles_tile_rect(const CanvasTiles *ct, int tile_idx);
+
+// Copies the pixels of rect (which must lie inside the canvas) into dst, a row-major
+// buffer dst_pitch pixels wide. Empty tiles read as the clear color.
+void canvas_tiles_read_rect(const CanvasTiles *ct, const SDL_Rect *rect, Uint32 *dst, int dst_pitch);
+
+// Copies tiles marked CANVAS_TILE_READBACK out of the canvas texture.
+// The texture must be a render target; the renderer target is reset afterwards.
+void canvas_tiles_readback(CanvasTiles *ct, SDL_Renderer *ren, SDL_Texture *canvas);
+
+// Like canvas_tiles_readback, for when the tiles are about to be drawn into on the CPU
+// in the middle of a stroke: their contents before the readback are kept as snapshots,
+// so the history step still records them.
+void canvas_tiles_readback_for_write(CanvasTiles *ct, SDL_Renderer *ren, SDL_Texture *canvas);
+
+// Copies tiles marked CANVAS_TILE_UPLOAD into the canvas texture.
+void canvas_tiles_upload(CanvasTiles *ct, SDL_Texture *canvas);
+
+// Like canvas_tiles_upload, for the tiles overlapping rect only. Call it before the GPU
+// draws into rect, so a later upload of older CPU pixels cannot paint over the result.
+void canvas_tiles_upload_rect(CanvasTiles *ct, SDL_Texture *canvas, const SDL_Rect *rect);
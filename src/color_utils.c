@@ -61,3 +61,14 @@ SDL_Color hsv_to_rgb(float h, float s, float v)
     rgb.b = (Uint8)SDL_lroundf(b1 * 255.0f);
     return rgb;
 }
+
+SDL_FColor color_to_fcolor(SDL_Color c)
+{
+    SDL_FColor fc = {
+        c.r / 255.0f,
+        c.g / 255.0f,
+        c.b / 255.0f,
+        c.a / 255.0f,
+    };
+    return fc;
+}
@@ -9,3 +9,11 @@
  * @return SDL_Color The equivalent RGB color.
  */
 SDL_Color hsv_to_rgb(float h, float s, float v);
+
+/**
+ * @brief Converts an 8-bit color to the normalized float color used by SDL_Vertex.
+ *
+ * @param c The color to convert.
+ * @return SDL_FColor The same color with each channel in [0, 1].
+ */
+SDL_FColor color_to_fcolor(SDL_Color c);
@@ -0,0 +1,66 @@
+#include "damage.h"
+
+static Sint64 rect_area(const SDL_Rect *r)
+{
+    return (Sint64)r->w * r->h;
+}
+
+static SDL_Rect rect_union(const SDL_Rect *a, const SDL_Rect *b)
+{
+    SDL_Rect u;
+    SDL_GetRectUnion(a, b, &u);
+    return u;
+}
+
+void damage_clear(DamageList *damage)
+{
+    damage->num_rects = 0;
+}
+
+bool damage_is_empty(const DamageList *damage)
+{
+    return damage->num_rects == 0;
+}
+
+void damage_add(DamageList *damage, const SDL_Rect *rect)
+{
+    if (SDL_RectEmpty(rect)) {
+        return;
+    }
+
+    SDL_Rect r = *rect;
+
+    // Keep absorbing existing rects while the union is no larger than the separate areas.
+    // Merging can make the result overlap rects that were checked earlier, so rescan.
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < damage->num_rects; ++i) {
+            SDL_Rect u = rect_union(&damage->rects[i], &r);
+            if (rect_area(&u) <= rect_area(&damage->rects[i]) + rect_area(&r)) {
+                r = u;
+                damage->rects[i] = damage->rects[--damage->num_rects];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (damage->num_rects < DAMAGE_MAX_RECTS) {
+        damage->rects[damage->num_rects++] = r;
+        return;
+    }
+
+    // List is full: merge into the rect whose area grows the least.
+    int best = 0;
+    Sint64 best_growth = -1;
+    for (int i = 0; i < damage->num_rects; ++i) {
+        SDL_Rect u = rect_union(&damage->rects[i], &r);
+        Sint64 growth = rect_area(&u) - rect_area(&damage->rects[i]);
+        if (best_growth < 0 || growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    damage->rects[best] = rect_union(&damage->rects[best], &r);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#define DAMAGE_MAX_RECTS 16 // Beyond this, new rects are merged into the closest existing one
+
+// A small list of window-space rectangles that changed since the last present.
+typedef struct DamageList {
+    SDL_Rect rects[DAMAGE_MAX_RECTS];
+    int num_rects;
+} DamageList;
+
+void damage_clear(DamageList *damage);
+bool damage_is_empty(const DamageList *damage);
+
+// Adds a rectangle, merging it with an existing one when that does not grow the
+// redrawn area beyond the two rectangles on their own.
+void damage_add(DamageList *damage, const SDL_Rect *rect);
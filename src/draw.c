@@ -1,4 +1,5 @@
 #include "draw.h"
+#include "perf_hud.h"
 
 void draw_line_bresenham(int x0, int y0, int x1, int y1, BresenhamCallback cb, void *userdata)
 {
@@ -26,56 +27,172 @@ void draw_line_bresenham(int x0, int y0, int x1, int y1, BresenhamCallback cb, v
     }
 }
 
-// Draw filled circle using horizontal scanlines.
-void draw_circle(SDL_Renderer *ren, float cx, float cy, int radius)
+// Compute the scanline spans of a filled circle. Radius 0 yields a single pixel.
+bool circle_spans_build(CircleSpans *cs, int radius)
 {
-    if (radius <= 0) {
-        if (radius == 0) {
-            if (!SDL_RenderPoint(ren, cx, cy)) {
-                SDL_Log("draw_circle: SDL_RenderPoint failed: %s", SDL_GetError());
-            }
-        }
-        return;
+    if (radius < 0) {
+        radius = 0;
+    }
+
+    SDL_Rect *spans = SDL_realloc(cs->spans, sizeof(SDL_Rect) * (2 * radius + 1));
+    if (!spans) {
+        SDL_Log("circle_spans_build: Failed to allocate spans for radius %d", radius);
+        return false;
     }
+    cs->spans = spans;
+    cs->radius = radius;
+    cs->num_spans = 0;
 
     for (int y = -radius; y <= radius; y++) {
         // Calculate the horizontal extent (x-span) for this scanline
         int x_span = (int)SDL_floorf(SDL_sqrtf((float)(radius * radius - y * y)));
-        if (!SDL_RenderLine(ren, cx - x_span, cy + y, cx + x_span, cy + y)) {
-            SDL_Log("draw_circle: SDL_RenderLine failed: %s", SDL_GetError());
+        if (cs->num_spans > 0 && spans[cs->num_spans - 1].x == -x_span) {
+            spans[cs->num_spans - 1].h++;
+            continue;
         }
+        SDL_Rect *span = &spans[cs->num_spans++];
+        span->x = -x_span;
+        span->y = y;
+        span->w = 2 * x_span + 1;
+        span->h = 1;
+    }
+    return true;
+}
+
+void circle_spans_free(CircleSpans *cs)
+{
+    if (!cs) {
+        return;
+    }
+    SDL_free(cs->spans);
+    cs->spans = NULL;
+    cs->num_spans = 0;
+    cs->radius = 0;
+}
+
+// Draw precomputed circle spans with the current draw color in a single call.
+void draw_circle_spans(SDL_Renderer *ren, const CircleSpans *cs, float cx, float cy)
+{
+    if (!cs || cs->num_spans <= 0) {
+        return;
+    }
+
+    SDL_FRect *rects = SDL_malloc(sizeof(SDL_FRect) * cs->num_spans);
+    if (!rects) {
+        SDL_Log("draw_circle_spans: Failed to allocate %d rects", cs->num_spans);
+        return;
+    }
+    for (int i = 0; i < cs->num_spans; ++i) {
+        rects[i].x = cx + cs->spans[i].x;
+        rects[i].y = cy + cs->spans[i].y;
+        rects[i].w = (float)cs->spans[i].w;
+        rects[i].h = (float)cs->spans[i].h;
     }
+    if (!SDL_RenderFillRects(ren, rects, cs->num_spans)) {
+        SDL_Log("draw_circle_spans: SDL_RenderFillRects failed: %s", SDL_GetError());
+    }
+    SDL_free(rects);
+}
+
+// Draw filled circle using horizontal scanlines.
+void draw_circle(SDL_Renderer *ren, float cx, float cy, int radius)
+{
+    if (radius < 0) {
+        return;
+    }
+
+    CircleSpans cs = {0};
+    if (circle_spans_build(&cs, radius)) {
+        draw_circle_spans(ren, &cs, cx, cy);
+    }
+    circle_spans_free(&cs);
+}
+
+#define HOLLOW_CIRCLE_THICKNESS 2
+
+// True if the pixel at offset (w, h) from the centre belongs to the hollow circle.
+static bool hollow_circle_contains(int radius, int w, int h)
+{
+    int dist_sq = w * w + h * h;
+    if (dist_sq > radius * radius) {
+        return false;
+    }
+    // For very small radii the circle is filled, as a 2px outline isn't meaningful.
+    if (radius <= HOLLOW_CIRCLE_THICKNESS) {
+        return true;
+    }
+    int inner_radius = radius - HOLLOW_CIRCLE_THICKNESS;
+    return dist_sq > inner_radius * inner_radius;
 }
 
 // Draw hollow (outline only) circle (for preview)
 void draw_hollow_circle(SDL_Renderer *ren, float cx, float cy, int radius)
 {
-    const int thickness = 2;
-
     if (radius < 1) {
         return;
     }
 
-    // For very small radii, draw a filled circle as a 2px outline isn't meaningful.
-    if (radius <= thickness) {
+    if (radius <= HOLLOW_CIRCLE_THICKNESS) {
         draw_circle(ren, cx, cy, radius);
         return;
     }
 
-    int outer_radius_sq = radius * radius;
-    int inner_radius = radius - thickness;
-    int inner_radius_sq = inner_radius * inner_radius;
+    const int side = 2 * radius + 1;
+    SDL_FPoint *points = SDL_malloc(sizeof(SDL_FPoint) * side * side);
+    if (!points) {
+        SDL_Log("draw_hollow_circle: Failed to allocate points for radius %d", radius);
+        return;
+    }
 
+    int num_points = 0;
     for (int w = -radius; w <= radius; ++w) {
         for (int h = -radius; h <= radius; ++h) {
-            int dist_sq = w * w + h * h;
-            if (dist_sq <= outer_radius_sq && dist_sq > inner_radius_sq) {
-                if (!SDL_RenderPoint(ren, cx + w, cy + h)) {
-                    SDL_Log("draw_hollow_circle: SDL_RenderPoint failed: %s", SDL_GetError());
-                }
+            if (hollow_circle_contains(radius, w, h)) {
+                points[num_points].x = cx + w;
+                points[num_points].y = cy + h;
+                num_points++;
             }
         }
     }
+    if (!SDL_RenderPoints(ren, points, num_points)) {
+        SDL_Log("draw_hollow_circle: SDL_RenderPoints failed: %s", SDL_GetError());
+    }
+    SDL_free(points);
+}
+
+SDL_Texture *draw_create_hollow_circle_texture(SDL_Renderer *ren, int radius)
+{
+    if (radius < 1) {
+        return NULL;
+    }
+
+    const int side = 2 * radius + 1;
+    SDL_Surface *surface = SDL_CreateSurface(side, side, SDL_PIXELFORMAT_RGBA8888);
+    if (!surface) {
+        SDL_Log("draw_create_hollow_circle_texture: SDL_CreateSurface failed: %s", SDL_GetError());
+        return NULL;
+    }
+
+    for (int y = 0; y < side; ++y) {
+        Uint32 *row = (Uint32 *)((Uint8 *)surface->pixels + y * surface->pitch);
+        for (int x = 0; x < side; ++x) {
+            row[x] = hollow_circle_contains(radius, x - radius, y - radius) ? 0xFFFFFFFFu : 0u;
+        }
+    }
+
+    SDL_Texture *tex = SDL_CreateTextureFromSurface(ren, surface);
+    SDL_DestroySurface(surface);
+    if (!tex) {
+        SDL_Log("draw_create_hollow_circle_texture: Failed to create texture: %s", SDL_GetError());
+        return NULL;
+    }
+    if (!SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND)) {
+        SDL_Log("draw_create_hollow_circle_texture: Failed to set blend mode: %s", SDL_GetError());
+    }
+    if (!SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST)) {
+        SDL_Log("draw_create_hollow_circle_texture: Failed to set scale mode: %s", SDL_GetError());
+    }
+    return tex;
 }
 
 // Draw a thick line with round caps using geometry for the shaft.
@@ -120,7 +237,7 @@ void draw_thick_line(
 
     // The rectangle is formed by two triangles: (0, 1, 3) and (1, 2, 3).
     int indices[6] = {0, 1, 3, 1, 2, 3};
-    if (!SDL_RenderGeometry(ren, NULL, vertices, 4, indices, 6)) {
+    if (!perf_render_geometry(ren, NULL, vertices, 4, indices, 6)) {
         SDL_Log("draw_thick_line: SDL_RenderGeometry failed: %s", SDL_GetError());
     }
 
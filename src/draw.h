@@ -2,9 +2,24 @@
 
 typedef void (*BresenhamCallback)(int x, int y, void *userdata);
 
+// Horizontal spans covering a filled circle, relative to its centre.
+// Consecutive scanlines of equal width are merged into a single rect.
+typedef struct CircleSpans {
+    int radius;
+    int num_spans;
+    SDL_Rect *spans;
+} CircleSpans;
+
 void draw_line_bresenham(int x0, int y0, int x1, int y1, BresenhamCallback cb, void *userdata);
 
+bool circle_spans_build(CircleSpans *cs, int radius);
+void circle_spans_free(CircleSpans *cs);
+
 void draw_circle(SDL_Renderer *ren, float cx, float cy, int radius);
+void draw_circle_spans(SDL_Renderer *ren, const CircleSpans *cs, float cx, float cy);
 void draw_hollow_circle(SDL_Renderer *ren, float cx, float cy, int radius);
+// Creates a white (2r+1)x(2r+1) texture with the same ring as draw_hollow_circle,
+// meant to be tinted with SDL_SetTextureColorMod. Returns NULL on failure.
+SDL_Texture *draw_create_hollow_circle_texture(SDL_Renderer *ren, int radius);
 void draw_thick_line(
     SDL_Renderer *ren, float x1, float y1, float x2, float y2, int thickness, SDL_Color color);
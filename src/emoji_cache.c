@@ -0,0 +1,239 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "emoji_cache.h"
+
+#define EMOJI_CACHE_FNV_OFFSET 0xcbf29ce484222325ULL
+#define EMOJI_CACHE_FNV_PRIME 0x100000001b3ULL
+
+typedef struct EmojiCacheHeader {
+    char magic[4]; // "PEMJ"
+    Uint32 version;
+    Uint64 key;
+    Uint32 num_glyphs;
+    Uint32 reserved;
+} EmojiCacheHeader;
+
+typedef struct EmojiCacheEntry {
+    Uint32 offset; // Of the pixels from the start of the file; 0 if the glyph is missing
+    Uint16 w;
+    Uint16 h; // Pixels are w * h * 4 bytes, rows tightly packed
+} EmojiCacheEntry;
+
+static Uint64 hash_bytes(Uint64 h, const void *data, size_t size)
+{
+    const Uint8 *p = (const Uint8 *)data;
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ p[i]) * EMOJI_CACHE_FNV_PRIME;
+    }
+    return h;
+}
+
+// FNV-1a over 64-bit words rather than bytes, which keeps hashing a large font cheap.
+static Uint64 hash_words(Uint64 h, const void *data, size_t size)
+{
+    const Uint8 *p = (const Uint8 *)data;
+    size_t words = size / sizeof(Uint64);
+    for (size_t i = 0; i < words; ++i) {
+        Uint64 w;
+        SDL_memcpy(&w, p + i * sizeof(w), sizeof(w));
+        h = (h ^ w) * EMOJI_CACHE_FNV_PRIME;
+    }
+    return hash_bytes(h, p + words * sizeof(Uint64), size % sizeof(Uint64));
+}
+
+static void *map_file(const char *path, size_t *size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *map = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            map = NULL;
+        } else {
+            *size = (size_t)st.st_size;
+        }
+    }
+    close(fd);
+    return map;
+}
+
+// $XDG_CACHE_HOME/paint, or ~/.cache/paint.
+static char *cache_dir(void)
+{
+    char *dir = NULL;
+    const char *xdg = SDL_getenv("XDG_CACHE_HOME");
+    const char *home = SDL_getenv("HOME");
+    if (xdg && *xdg) {
+        SDL_asprintf(&dir, "%s/paint", xdg);
+    } else if (home && *home) {
+        SDL_asprintf(&dir, "%s/.cache/paint", home);
+    }
+    return dir;
+}
+
+bool emoji_disk_cache_open(EmojiDiskCache *c, const char *font_path, int font_size,
+                           SDL_PixelFormat format, const char *const *codepoints, int count)
+{
+    SDL_zerop(c);
+    char *dir = cache_dir();
+    if (!dir) {
+        return false;
+    }
+    SDL_asprintf(&c->path, "%s/emoji-%d.cache", dir, font_size);
+    SDL_free(dir);
+    if (!c->path) {
+        return false;
+    }
+
+    size_t font_size_bytes = 0;
+    void *font = map_file(font_path, &font_size_bytes);
+    if (!font) {
+        SDL_Log("Emoji cache: Failed to map font '%s'", font_path);
+        SDL_free(c->path);
+        c->path = NULL;
+        return false;
+    }
+    Uint64 key = hash_words(EMOJI_CACHE_FNV_OFFSET, font, font_size_bytes);
+    munmap(font, font_size_bytes);
+
+    Uint32 params[3] = {(Uint32)font_size, (Uint32)format, (Uint32)count};
+    key = hash_bytes(key, params, sizeof(params));
+    for (int i = 0; i < count; ++i) {
+        const char *cp = codepoints[i] ? codepoints[i] : "";
+        key = hash_bytes(key, cp, SDL_strlen(cp) + 1);
+    }
+    c->key = key;
+    c->format = format;
+    return true;
+}
+
+int emoji_disk_cache_load(EmojiDiskCache *c, SDL_Surface **surfaces, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        surfaces[i] = NULL;
+    }
+    if (!c->path) {
+        return 0;
+    }
+
+    size_t size = 0;
+    void *map = map_file(c->path, &size);
+    if (!map) {
+        return 0;
+    }
+
+    const EmojiCacheHeader *hdr = (const EmojiCacheHeader *)map;
+    size_t table_end = sizeof(*hdr) + sizeof(EmojiCacheEntry) * (size_t)count;
+    if (size < table_end || SDL_memcmp(hdr->magic, "PEMJ", 4) != 0 ||
+        hdr->version != EMOJI_CACHE_VERSION || hdr->key != c->key ||
+        hdr->num_glyphs != (Uint32)count) {
+        munmap(map, size);
+        return 0;
+    }
+
+    const EmojiCacheEntry *entries = (const EmojiCacheEntry *)(hdr + 1);
+    int found = 0;
+    for (int i = 0; i < count; ++i) {
+        const EmojiCacheEntry *e = &entries[i];
+        size_t bytes = (size_t)e->w * e->h * 4;
+        if (e->offset == 0 || bytes == 0 || e->offset < table_end || e->offset % 4 != 0 ||
+            e->offset + bytes > size) {
+            continue;
+        }
+        // The mapping is read-only; glyph surfaces are never written to.
+        surfaces[i] = SDL_CreateSurfaceFrom(
+            e->w, e->h, c->format, (Uint8 *)map + e->offset, e->w * 4);
+        if (surfaces[i]) {
+            ++found;
+        }
+    }
+
+    c->map = map;
+    c->map_size = size;
+    return found;
+}
+
+bool emoji_disk_cache_save(const EmojiDiskCache *c, SDL_Surface *const *surfaces, int count)
+{
+    if (!c->path) {
+        return false;
+    }
+    char *dir = cache_dir();
+    if (!dir || !SDL_CreateDirectory(dir)) {
+        SDL_Log("Emoji cache: Failed to create cache directory: %s", SDL_GetError());
+        SDL_free(dir);
+        return false;
+    }
+    SDL_free(dir);
+
+    EmojiCacheEntry *entries = SDL_calloc(count, sizeof(*entries));
+    char *tmp_path = NULL;
+    SDL_asprintf(&tmp_path, "%s.tmp", c->path);
+    if (!entries || !tmp_path) {
+        SDL_free(entries);
+        SDL_free(tmp_path);
+        return false;
+    }
+
+    Uint32 offset = (Uint32)(sizeof(EmojiCacheHeader) + sizeof(*entries) * count);
+    for (int i = 0; i < count; ++i) {
+        const SDL_Surface *s = surfaces[i];
+        if (!s || s->format != c->format || s->w > 0xffff || s->h > 0xffff) {
+            continue;
+        }
+        entries[i].offset = offset;
+        entries[i].w = (Uint16)s->w;
+        entries[i].h = (Uint16)s->h;
+        offset += (Uint32)(s->w * s->h * 4);
+    }
+
+    // Write a new file and move it into place, so a reader never sees half of one.
+    EmojiCacheHeader hdr = {{'P', 'E', 'M', 'J'}, EMOJI_CACHE_VERSION, c->key, (Uint32)count, 0};
+    SDL_IOStream *io = SDL_IOFromFile(tmp_path, "wb");
+    bool ok = io != NULL;
+    ok = ok && SDL_WriteIO(io, &hdr, sizeof(hdr)) == sizeof(hdr);
+    ok = ok && SDL_WriteIO(io, entries, sizeof(*entries) * count) == sizeof(*entries) * count;
+    for (int i = 0; ok && i < count; ++i) {
+        const SDL_Surface *s = surfaces[i];
+        if (entries[i].offset == 0) {
+            continue;
+        }
+        const size_t row = (size_t)s->w * 4;
+        for (int y = 0; ok && y < s->h; ++y) {
+            ok = SDL_WriteIO(io, (const Uint8 *)s->pixels + (size_t)y * s->pitch, row) == row;
+        }
+    }
+    if (io && !SDL_CloseIO(io)) {
+        ok = false;
+    }
+    if (ok) {
+        ok = SDL_RenamePath(tmp_path, c->path);
+    }
+    if (!ok) {
+        SDL_Log("Emoji cache: Failed to write '%s': %s", c->path, SDL_GetError());
+        SDL_RemovePath(tmp_path);
+    }
+
+    SDL_free(entries);
+    SDL_free(tmp_path);
+    return ok;
+}
+
+void emoji_disk_cache_close(EmojiDiskCache *c)
+{
+    if (!c) {
+        return;
+    }
+    if (c->map) {
+        munmap(c->map, c->map_size);
+    }
+    SDL_free(c->path);
+    SDL_zerop(c);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#define EMOJI_CACHE_VERSION 1
+
+/*
+ * Rasterized emoji glyphs saved between runs, so a warm start maps a file
+ * instead of rendering every glyph through the font again.
+ *
+ * The file lives in the user's cache directory and holds a header, one entry
+ * per emoji and the tightly packed pixels of each glyph. It is only used when
+ * its key matches: a hash of the font file, the font size, the pixel format
+ * and the list of emojis.
+ */
+typedef struct EmojiDiskCache {
+    char *path; // NULL if no cache directory is available
+    Uint64 key;
+    SDL_PixelFormat format; // Of every glyph in the file
+    void *map; // Read-only mapping of the file; loaded surfaces point into it
+    size_t map_size;
+} EmojiDiskCache;
+
+// Works out the path and key. Returns false if there is nowhere to keep a cache.
+bool emoji_disk_cache_open(EmojiDiskCache *c, const char *font_path, int font_size,
+                           SDL_PixelFormat format, const char *const *codepoints, int count);
+
+// Maps the file and fills surfaces[i] for every glyph it holds, leaving the rest NULL.
+// The surfaces share the mapped pixels and must be destroyed before
+// emoji_disk_cache_close. Returns the number of glyphs found.
+int emoji_disk_cache_load(EmojiDiskCache *c, SDL_Surface **surfaces, int count);
+
+// Writes every non-NULL surface (all in the cache's format) to a new cache file.
+bool emoji_disk_cache_save(const EmojiDiskCache *c, SDL_Surface *const *surfaces, int count);
+
+void emoji_disk_cache_close(EmojiDiskCache *c);
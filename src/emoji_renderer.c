@@ -1,14 +1,16 @@
+#include "emoji_cache.h"
 #include "emoji_data.h"
 #include "emoji_renderer.h"
+#include "perf_hud.h"
 
-// Fisher-Yates shuffle for an array of char pointers
-static void shuffle_char_pointers(const char **array, int n)
+// Fisher-Yates shuffle for an array of indices
+static void shuffle_indices(int *array, int n)
 {
     if (n > 1) {
         int i = n - 1;
         while (i > 0) {
             int j = SDL_rand(i + 1);
-            const char *temp = array[j];
+            int temp = array[j];
             array[j] = array[i];
             array[i] = temp;
             i--;
@@ -16,17 +18,315 @@ static void shuffle_char_pointers(const char **array, int n)
     }
 }
 
-static void clear_rendered_emojis(EmojiRenderer *er)
+// Fills the whole page with transparent pixels, so no old glyph can bleed into a new one.
+static bool atlas_page_clear(EmojiAtlasPage *page)
 {
-    if (er->emoji_textures) {
-        for (int i = 0; i < er->num_defined_emojis; ++i) {
-            if (er->emoji_textures[i]) {
-                SDL_DestroyTexture(er->emoji_textures[i]);
-                er->emoji_textures[i] = NULL;
+    const int pitch = EMOJI_ATLAS_PAGE_SIZE * 4;
+    Uint8 *zeros = SDL_calloc(EMOJI_ATLAS_PAGE_SIZE, pitch);
+    if (!zeros) {
+        SDL_Log("Failed to allocate emoji atlas clear buffer");
+        return false;
+    }
+    bool ok = perf_update_texture(page->texture, NULL, zeros, pitch);
+    if (!ok) {
+        SDL_Log("Failed to clear emoji atlas page: %s", SDL_GetError());
+    }
+    SDL_free(zeros);
+
+    page->shelf_y = 0;
+    page->shelf_h = 0;
+    page->cursor_x = 0;
+    return ok;
+}
+
+static int atlas_page_create(EmojiRenderer *er)
+{
+    if (er->num_pages == EMOJI_ATLAS_MAX_PAGES) {
+        return -1;
+    }
+    EmojiAtlasPage *page = &er->pages[er->num_pages];
+    SDL_zerop(page);
+    page->texture = SDL_CreateTexture(er->ren_ref,
+                                      EMOJI_ATLAS_FORMAT,
+                                      SDL_TEXTUREACCESS_STATIC,
+                                      EMOJI_ATLAS_PAGE_SIZE,
+                                      EMOJI_ATLAS_PAGE_SIZE);
+    if (!page->texture) {
+        SDL_Log("Failed to create emoji atlas page: %s", SDL_GetError());
+        return -1;
+    }
+    if (!SDL_SetTextureBlendMode(page->texture, SDL_BLENDMODE_BLEND)) {
+        SDL_Log("Failed to set blend mode for emoji atlas page: %s", SDL_GetError());
+    }
+    if (!atlas_page_clear(page)) {
+        SDL_DestroyTexture(page->texture);
+        page->texture = NULL;
+        return -1;
+    }
+    return er->num_pages++;
+}
+
+// Empties the page; its glyphs are uploaded again from their surfaces when next used.
+static void atlas_page_recycle(EmojiRenderer *er, int page_idx)
+{
+    for (int i = 0; i < er->num_defined_emojis; ++i) {
+        if (er->glyphs[i].page == page_idx) {
+            er->glyphs[i].page = -1;
+        }
+    }
+    atlas_page_clear(&er->pages[page_idx]);
+}
+
+// Places a w x h glyph on the page's current shelf, or on a new shelf below it.
+static bool atlas_page_alloc(EmojiAtlasPage *page, int w, int h, SDL_Rect *out)
+{
+    const int pw = w + 2 * EMOJI_ATLAS_PADDING;
+    const int ph = h + 2 * EMOJI_ATLAS_PADDING;
+    if (pw > EMOJI_ATLAS_PAGE_SIZE || ph > EMOJI_ATLAS_PAGE_SIZE) {
+        return false;
+    }
+    if (page->cursor_x + pw > EMOJI_ATLAS_PAGE_SIZE) {
+        page->shelf_y += page->shelf_h;
+        page->shelf_h = 0;
+        page->cursor_x = 0;
+    }
+    if (page->shelf_y + ph > EMOJI_ATLAS_PAGE_SIZE) {
+        return false;
+    }
+
+    *out = (SDL_Rect) {
+        page->cursor_x + EMOJI_ATLAS_PADDING, page->shelf_y + EMOJI_ATLAS_PADDING, w, h
+    };
+    page->cursor_x += pw;
+    page->shelf_h = SDL_max(page->shelf_h, ph);
+    return true;
+}
+
+// Finds room for a glyph: on an existing page, on a new page, or on a recycled one.
+// Sets *pinned if only pinned pages could have been recycled.
+static int atlas_alloc(EmojiRenderer *er, int w, int h, SDL_Rect *out, bool *pinned)
+{
+    *pinned = false;
+    for (int i = 0; i < er->num_pages; ++i) {
+        if (atlas_page_alloc(&er->pages[i], w, h, out)) {
+            return i;
+        }
+    }
+
+    int page_idx = atlas_page_create(er);
+    if (page_idx == -1) {
+        if (er->num_pages == 0) {
+            return -1;
+        }
+        for (int i = 0; i < er->num_pages; ++i) {
+            if (er->pages[i].last_used < er->pin_clock &&
+                (page_idx == -1 || er->pages[i].last_used < er->pages[page_idx].last_used)) {
+                page_idx = i;
             }
         }
+        if (page_idx == -1) {
+            *pinned = true;
+            return -1;
+        }
+        atlas_page_recycle(er, page_idx);
+    }
+    return atlas_page_alloc(&er->pages[page_idx], w, h, out) ? page_idx : -1;
+}
+
+// A finished glyph, handed from the worker to the main thread.
+typedef struct EmojiRasterResult {
+    int idx;
+    SDL_Surface *surface; // NULL if rasterization failed
+} EmojiRasterResult;
+
+// Renders one emoji into a new surface in the atlas format. Touches no renderer state.
+static SDL_Surface *rasterize_emoji(TTF_Font *font, const char *codepoint)
+{
+    if (!codepoint || *codepoint == '\0') {
+        return NULL;
+    }
+
+    SDL_Color fg_color = {0, 0, 0, 255}; // Emojis are typically rendered with their own colors
+    SDL_Surface *surface = TTF_RenderText_Blended(font, codepoint, 0, fg_color);
+    if (!surface) {
+        SDL_Log("Failed to render emoji '%s': %s", codepoint, SDL_GetError());
+        return NULL;
+    }
+    if (surface->format != EMOJI_ATLAS_FORMAT) {
+        SDL_Surface *converted = SDL_ConvertSurface(surface, EMOJI_ATLAS_FORMAT);
+        SDL_DestroySurface(surface);
+        surface = converted;
+        if (!surface) {
+            SDL_Log("Failed to convert emoji '%s': %s", codepoint, SDL_GetError());
+            return NULL;
+        }
+    }
+    return surface;
+}
+
+// Worker thread: rasterizes requested glyphs until told to quit.
+static int emoji_worker(void *data)
+{
+    EmojiRenderer *er = (EmojiRenderer *)data;
+    for (;;) {
+        SDL_WaitSemaphore(er->work_ready);
+        if (SDL_GetAtomicInt(&er->quit)) {
+            break;
+        }
+        int idx;
+        if (!spsc_ring_pop(&er->requests, &idx)) {
+            continue;
+        }
+
+        EmojiRasterResult result = {
+            idx, rasterize_emoji(er->emoji_font, ORIGINAL_DEFAULT_EMOJI_CODEPOINTS[idx])
+        };
+        // Every glyph is requested at most once and the ring holds them all.
+        if (!spsc_ring_push(&er->results, &result)) {
+            SDL_DestroySurface(result.surface);
+            continue;
+        }
+        if (er->wake_event) {
+            SDL_Event e;
+            SDL_zero(e);
+            e.type = er->wake_event;
+            SDL_PushEvent(&e);
+        }
+    }
+    return 0;
+}
+
+static void store_result(EmojiRenderer *er, const EmojiRasterResult *result)
+{
+    EmojiGlyph *g = &er->glyphs[result->idx];
+    g->requested = false;
+    g->surface = result->surface;
+    g->failed = !result->surface;
+    if (g->surface) {
+        er->disk_cache_dirty = true;
+    }
+}
+
+// Takes every glyph the disk cache has, so those never go through the font.
+static void load_disk_cache(EmojiRenderer *er)
+{
+    er->disk_cache_dirty = false;
+    if (!emoji_disk_cache_open(&er->disk_cache,
+                               EMOJI_FONT_PATH,
+                               EMOJI_FONT_SIZE,
+                               EMOJI_ATLAS_FORMAT,
+                               ORIGINAL_DEFAULT_EMOJI_CODEPOINTS,
+                               er->num_defined_emojis)) {
+        return;
+    }
+    SDL_Surface **surfaces = SDL_malloc(sizeof(*surfaces) * er->num_defined_emojis);
+    if (!surfaces) {
+        return;
+    }
+    int found = emoji_disk_cache_load(&er->disk_cache, surfaces, er->num_defined_emojis);
+    for (int i = 0; i < er->num_defined_emojis; ++i) {
+        er->glyphs[i].surface = surfaces[i];
+    }
+    SDL_free(surfaces);
+    SDL_Log("Emoji cache: %d of %d glyphs loaded", found, er->num_defined_emojis);
+}
+
+// Writes the glyphs back if any were rendered this run.
+static void save_disk_cache(EmojiRenderer *er)
+{
+    if (!er->disk_cache_dirty) {
+        return;
+    }
+    SDL_Surface **surfaces = SDL_malloc(sizeof(*surfaces) * er->num_defined_emojis);
+    if (!surfaces) {
+        return;
+    }
+    for (int i = 0; i < er->num_defined_emojis; ++i) {
+        surfaces[i] = er->glyphs[i].surface;
+    }
+    emoji_disk_cache_save(&er->disk_cache, surfaces, er->num_defined_emojis);
+    SDL_free(surfaces);
+}
+
+// Queues a glyph for the worker, or renders it right away if there is none. The font
+// belongs to the worker while it runs; if its queue is full the glyph stays unrequested
+// and the next lookup tries again.
+static void request_glyph(EmojiRenderer *er, int idx)
+{
+    EmojiGlyph *g = &er->glyphs[idx];
+    if (g->requested) {
+        return;
+    }
+    if (er->worker) {
+        if (spsc_ring_push(&er->requests, &idx)) {
+            g->requested = true;
+            SDL_SignalSemaphore(er->work_ready);
+        }
+        return;
+    }
+    EmojiRasterResult result = {
+        idx, rasterize_emoji(er->emoji_font, ORIGINAL_DEFAULT_EMOJI_CODEPOINTS[idx])
+    };
+    store_result(er, &result);
+}
+
+static void start_worker(EmojiRenderer *er)
+{
+    if (SDL_GetHintBoolean(EMOJI_HINT_SYNCHRONOUS, false)) {
+        return;
+    }
+    if (!spsc_ring_init(&er->requests, er->num_defined_emojis, sizeof(int)) ||
+        !spsc_ring_init(&er->results, er->num_defined_emojis, sizeof(EmojiRasterResult))) {
+        return;
+    }
+    er->work_ready = SDL_CreateSemaphore(0);
+    if (!er->work_ready) {
+        SDL_Log("Failed to create emoji worker semaphore: %s", SDL_GetError());
+        return;
+    }
+    er->wake_event = SDL_RegisterEvents(1);
+    SDL_SetAtomicInt(&er->quit, 0);
+    er->worker = SDL_CreateThread(emoji_worker, "emoji", er);
+    if (!er->worker) {
+        SDL_Log("Failed to start emoji worker, rendering on the main thread: %s", SDL_GetError());
+    }
+}
+
+static void stop_worker(EmojiRenderer *er)
+{
+    if (er->worker) {
+        SDL_SetAtomicInt(&er->quit, 1);
+        SDL_SignalSemaphore(er->work_ready);
+        SDL_WaitThread(er->worker, NULL);
+        er->worker = NULL;
+        emoji_renderer_pump(er); // Take ownership of anything finished meanwhile
+    }
+    if (er->work_ready) {
+        SDL_DestroySemaphore(er->work_ready);
+        er->work_ready = NULL;
+    }
+    spsc_ring_free(&er->requests);
+    spsc_ring_free(&er->results);
+}
+
+// Copies a rasterized glyph into the atlas.
+static void upload_glyph(EmojiRenderer *er, int idx)
+{
+    EmojiGlyph *g = &er->glyphs[idx];
+    const SDL_Surface *surface = g->surface;
+    bool pinned;
+    g->page = atlas_alloc(er, surface->w, surface->h, &g->rect, &pinned);
+    if (g->page == -1 && pinned) {
+        return; // Every page is in use this frame; try again on a later lookup
+    }
+    if (g->page == -1) {
+        SDL_Log("No room in the emoji atlas for emoji %d (%dx%d)", idx, surface->w, surface->h);
+        g->failed = true;
+    } else if (!perf_update_texture(er->pages[g->page].texture, &g->rect, surface->pixels, surface->pitch)) {
+        SDL_Log("Failed to upload emoji %d to the atlas: %s", idx, SDL_GetError());
+        g->page = -1;
+        g->failed = true;
     }
-    // Dimensions are part of the texture info, no separate free needed if textures are cleared
 }
 
 EmojiRenderer *emoji_renderer_create(SDL_Renderer *ren)
@@ -46,39 +346,36 @@ EmojiRenderer *emoji_renderer_create(SDL_Renderer *ren)
     }
 
     er->num_defined_emojis = NUM_DEFAULT_EMOJIS;
-    er->emoji_codepoints_shuffled = NULL;
-    er->emoji_textures = NULL;
-    er->emoji_texture_dims = NULL;
+    er->order = NULL;
+    er->glyphs = NULL;
+    er->num_pages = 0;
+    er->use_clock = 0;
+    er->pin_clock = SDL_MAX_UINT64;
+    er->worker = NULL;
+    er->work_ready = NULL;
+    er->wake_event = 0;
+    SDL_zero(er->requests);
+    SDL_zero(er->results);
+    SDL_zero(er->disk_cache);
+    er->disk_cache_dirty = false;
 
     if (er->num_defined_emojis > 0) {
-        er->emoji_codepoints_shuffled =
-            (const char **)SDL_malloc(sizeof(char *) * er->num_defined_emojis);
-        if (!er->emoji_codepoints_shuffled) {
-            SDL_Log("Failed to allocate memory for shuffled emoji codepoints.");
+        er->order = (int *)SDL_malloc(sizeof(int) * er->num_defined_emojis);
+        er->glyphs = (EmojiGlyph *)SDL_calloc(er->num_defined_emojis, sizeof(EmojiGlyph));
+        if (!er->order || !er->glyphs) {
+            SDL_Log("Failed to allocate memory for emoji glyphs.");
             TTF_CloseFont(er->emoji_font);
+            SDL_free(er->order);
+            SDL_free(er->glyphs);
             SDL_free(er);
             return NULL;
         }
-        // Copy pointers from the original static array
         for (int i = 0; i < er->num_defined_emojis; ++i) {
-            er->emoji_codepoints_shuffled[i] = ORIGINAL_DEFAULT_EMOJI_CODEPOINTS[i];
-        }
-
-        er->emoji_textures =
-            (SDL_Texture **)SDL_calloc(er->num_defined_emojis, sizeof(SDL_Texture *));
-        er->emoji_texture_dims =
-            (SDL_Point *)SDL_calloc(er->num_defined_emojis, sizeof(SDL_Point));
-
-        if (!er->emoji_textures || !er->emoji_texture_dims) {
-            SDL_Log("Failed to allocate memory for emoji textures/dims.");
-            TTF_CloseFont(er->emoji_font);
-            SDL_free(er->emoji_codepoints_shuffled);
-            SDL_free(er->emoji_textures);
-            SDL_free(er->emoji_texture_dims);
-            SDL_free(er);
-            return NULL;
+            er->order[i] = i;
+            er->glyphs[i].page = -1;
         }
-        emoji_renderer_shuffle_and_render_all(er); // Initial shuffle and render
+        load_disk_cache(er);
+        emoji_renderer_shuffle(er); // Initial shuffle; glyphs are rendered when first shown
     }
 
     er->default_emoji_texture = NULL;
@@ -102,6 +399,10 @@ EmojiRenderer *emoji_renderer_create(SDL_Renderer *ren)
         SDL_Log("Failed to render default emoji: %s", SDL_GetError());
     }
 
+    // From here on the font belongs to the worker thread.
+    if (er->num_defined_emojis > 0) {
+        start_worker(er);
+    }
     return er;
 }
 
@@ -110,10 +411,19 @@ void emoji_renderer_destroy(EmojiRenderer *er)
     if (!er) {
         return;
     }
-    clear_rendered_emojis(er);
-    SDL_free(er->emoji_textures);
-    SDL_free(er->emoji_texture_dims);
-    SDL_free(er->emoji_codepoints_shuffled); // Free the array of pointers, not the strings themselves
+    stop_worker(er);
+    for (int i = 0; i < er->num_pages; ++i) {
+        SDL_DestroyTexture(er->pages[i].texture);
+    }
+    if (er->glyphs) {
+        save_disk_cache(er);
+        for (int i = 0; i < er->num_defined_emojis; ++i) {
+            SDL_DestroySurface(er->glyphs[i].surface);
+        }
+    }
+    emoji_disk_cache_close(&er->disk_cache); // After the surfaces that point into it
+    SDL_free(er->glyphs);
+    SDL_free(er->order);
 
     if (er->default_emoji_texture) {
         SDL_DestroyTexture(er->default_emoji_texture);
@@ -125,79 +435,61 @@ void emoji_renderer_destroy(EmojiRenderer *er)
     SDL_free(er);
 }
 
-void emoji_renderer_shuffle_and_render_all(EmojiRenderer *er)
+void emoji_renderer_shuffle(EmojiRenderer *er)
 {
-    if (!er || !er->emoji_font || !er->ren_ref || er->num_defined_emojis == 0 ||
-        !er->emoji_codepoints_shuffled) {
+    if (!er || !er->order) {
         return;
     }
-
-    // Shuffle the copied pointers
-    shuffle_char_pointers(er->emoji_codepoints_shuffled, er->num_defined_emojis);
-
-    // Clear any previously rendered textures
-    clear_rendered_emojis(er);
-
-    SDL_Color fg_color = {0, 0, 0, 255}; // Emojis are typically rendered with their own colors
-    for (int i = 0; i < er->num_defined_emojis; ++i) {
-        const char *codepoint = er->emoji_codepoints_shuffled[i];
-        if (!codepoint || *codepoint == '\0') {
-            er->emoji_textures[i] = NULL;
-            er->emoji_texture_dims[i] = (SDL_Point) {
-                0, 0
-            };
-            continue;
-        }
-        SDL_Surface *surface =
-            TTF_RenderText_Blended(er->emoji_font, codepoint, 0, fg_color);
-        if (!surface) {
-            SDL_Log("Failed to render emoji '%s': %s", codepoint, SDL_GetError());
-            er->emoji_textures[i] = NULL;
-            er->emoji_texture_dims[i] = (SDL_Point) {
-                0, 0
-            };
-            continue;
-        }
-        er->emoji_textures[i] = SDL_CreateTextureFromSurface(er->ren_ref, surface);
-        if (!er->emoji_textures[i]) {
-            SDL_Log("Failed to create texture for emoji '%s': %s", codepoint, SDL_GetError());
-            er->emoji_texture_dims[i] = (SDL_Point) {
-                0, 0
-            };
-        } else {
-            er->emoji_texture_dims[i] = (SDL_Point) {
-                surface->w, surface->h
-            };
-        }
-        SDL_DestroySurface(surface);
-    }
+    shuffle_indices(er->order, er->num_defined_emojis);
 }
 
-bool emoji_renderer_get_texture_info(const EmojiRenderer *er,
+bool emoji_renderer_get_texture_info(EmojiRenderer *er,
                                      int emoji_array_idx,
                                      SDL_Texture **tex,
+                                     SDL_FRect *src,
                                      int *w,
                                      int *h)
 {
-    if (!er || !tex || !w || !h || emoji_array_idx < 0 ||
-        emoji_array_idx >= er->num_defined_emojis) {
+    if (!er || !tex || !src || !w || !h || emoji_array_idx < 0 ||
+        emoji_array_idx >= er->num_defined_emojis || !er->glyphs) {
         return false;
     }
-    if (!er->emoji_textures || !er->emoji_texture_dims || !er->emoji_textures[emoji_array_idx]) {
-        return false;
+
+    int idx = er->order[emoji_array_idx];
+    EmojiGlyph *g = &er->glyphs[idx];
+    if (g->page == -1) {
+        if (g->failed) {
+            return false;
+        }
+        if (!g->surface) {
+            request_glyph(er, idx);
+        }
+        if (!g->surface) {
+            return false; // Still being rasterized
+        }
+        upload_glyph(er, idx);
+        if (g->page == -1) {
+            return false;
+        }
     }
-    *tex = er->emoji_textures[emoji_array_idx];
-    *w = er->emoji_texture_dims[emoji_array_idx].x;
-    *h = er->emoji_texture_dims[emoji_array_idx].y;
+
+    er->pages[g->page].last_used = ++er->use_clock;
+    *tex = er->pages[g->page].texture;
+    *src = (SDL_FRect) {
+        (float)g->rect.x, (float)g->rect.y, (float)g->rect.w, (float)g->rect.h
+    };
+    *w = g->rect.w;
+    *h = g->rect.h;
     return true;
 }
 
 bool emoji_renderer_get_default_texture_info(const EmojiRenderer *er,
                                              SDL_Texture **tex,
+                                             SDL_FRect *src,
                                              int *w,
                                              int *h)
 {
-    if (!er || !tex || !w || !h || !er->default_emoji_texture) {
+    if (!er || !tex || !src || !w || !h || !er->default_emoji_texture) {
         if (tex) {
             *tex = NULL;
         }
@@ -206,9 +498,49 @@ bool emoji_renderer_get_default_texture_info(const EmojiRenderer *er,
     *tex = er->default_emoji_texture;
     *w = er->default_emoji_texture_dims.x;
     *h = er->default_emoji_texture_dims.y;
+    *src = (SDL_FRect) {
+        0.0f, 0.0f, (float)*w, (float)*h
+    };
     return true;
 }
 
+int emoji_renderer_pump(EmojiRenderer *er)
+{
+    if (!er || !er->results.slots) {
+        return 0;
+    }
+    int count = 0;
+    EmojiRasterResult result;
+    while (spsc_ring_pop(&er->results, &result)) {
+        store_result(er, &result);
+        ++count;
+    }
+    return count;
+}
+
+bool emoji_renderer_is_pending(const EmojiRenderer *er, int emoji_array_idx)
+{
+    if (!er || emoji_array_idx < 0 || emoji_array_idx >= er->num_defined_emojis || !er->glyphs) {
+        return false;
+    }
+    const EmojiGlyph *g = &er->glyphs[er->order[emoji_array_idx]];
+    return g->requested || (g->surface && g->page == -1 && !g->failed);
+}
+
+void emoji_renderer_pin_pages(EmojiRenderer *er)
+{
+    if (er) {
+        er->pin_clock = er->use_clock + 1;
+    }
+}
+
+void emoji_renderer_unpin_pages(EmojiRenderer *er)
+{
+    if (er) {
+        er->pin_clock = SDL_MAX_UINT64;
+    }
+}
+
 int emoji_renderer_get_num_emojis(const EmojiRenderer *er)
 {
     if (!er) {
@@ -1,42 +1,114 @@
 #pragma once
 
+#include "emoji_cache.h"
+#include "spsc_ring.h"
+
 // Ensure this font is available
 #define EMOJI_FONT_PATH "/usr/share/fonts/noto/NotoColorEmoji.ttf"
 #define EMOJI_FONT_SIZE 48 // Font size for rendering emojis to texture
 
+#define EMOJI_ATLAS_PAGE_SIZE 1024 // Width and height of one atlas texture
+#define EMOJI_ATLAS_MAX_PAGES 4    // Least recently used page is recycled beyond this
+#define EMOJI_ATLAS_PADDING 1      // Transparent gap around each glyph, against filtering bleed
+#define EMOJI_ATLAS_FORMAT SDL_PIXELFORMAT_ARGB8888
+
+// SDL hint: rasterize glyphs on the thread that asks for them, so that what gets drawn
+// never depends on worker timing. Used for deterministic replays.
+#define EMOJI_HINT_SYNCHRONOUS "PAINT_EMOJI_SYNCHRONOUS"
+
+/*
+ * One texture that glyphs are packed into, shelf by shelf: glyphs are placed
+ * left to right on the current shelf, and a new shelf is opened below it when
+ * the row is full. Pages are only ever emptied as a whole.
+ */
+typedef struct EmojiAtlasPage {
+    SDL_Texture *texture;
+    int shelf_y;      // Top of the current shelf
+    int shelf_h;      // Height of the tallest glyph on the current shelf
+    int cursor_x;     // Next free column on the current shelf
+    Uint64 last_used; // Value of use_clock when a glyph on this page was last looked up
+} EmojiAtlasPage;
+
+/*
+ * One emoji of ORIGINAL_DEFAULT_EMOJI_CODEPOINTS. It is rasterized once, on first
+ * use, into an immutable CPU surface; the atlas only holds uploaded copies, so a
+ * recycled page is refilled from the surfaces without going through the font again.
+ */
+typedef struct EmojiGlyph {
+    SDL_Surface *surface; // In EMOJI_ATLAS_FORMAT; never modified once rendered
+    int page;       // Atlas page holding the glyph, or -1 if it is not resident
+    SDL_Rect rect;  // Area of the glyph on its page
+    bool failed;    // Rasterization failed once; do not retry
+    bool requested; // Queued for the worker, result not collected yet
+} EmojiGlyph;
+
 typedef struct EmojiRenderer {
     TTF_Font *emoji_font;
-    const char **emoji_codepoints_shuffled; // Shuffled copy of original codepoints
-    SDL_Texture **emoji_textures;
-    SDL_Point *emoji_texture_dims;
+    int *order;         // Shuffled permutation of original emoji indices
+    EmojiGlyph *glyphs; // Indexed by original emoji index, so shuffling keeps them
     int num_defined_emojis;
     SDL_Renderer *ren_ref;
 
+    EmojiAtlasPage pages[EMOJI_ATLAS_MAX_PAGES];
+    int num_pages;
+    Uint64 use_clock; // Advances on every glyph lookup
+    Uint64 pin_clock; // Pages looked up at or after this use_clock value are not recycled
+
+    // Glyphs are rasterized on a worker thread, which owns the font once started,
+    // and collected by emoji_renderer_pump on the main thread. Without a worker they
+    // are rasterized on the main thread when first requested.
+    SDL_Thread *worker;
+    SDL_Semaphore *work_ready; // Signalled once per request, and once to quit
+    SDL_AtomicInt quit;
+    SpscRing requests; // Main thread -> worker: original emoji indices
+    SpscRing results;  // Worker -> main thread: finished surfaces
+    Uint32 wake_event; // Pushed after each finished glyph to wake the event loop (0: none)
+
+    EmojiDiskCache disk_cache; // Glyphs from earlier runs; written back on destroy
+    bool disk_cache_dirty;     // Some glyph was rendered this run
+
     // For showing a default icon in the UI when the brush tool is active
     SDL_Texture *default_emoji_texture;
     SDL_Point default_emoji_texture_dims;
 } EmojiRenderer;
 
 // Creates an EmojiRenderer instance.
-// Loads the emoji font and prepares for rendering.
+// Loads the emoji font and prepares for rendering. No emoji is rasterized yet.
 // Returns NULL on failure.
 EmojiRenderer *emoji_renderer_create(SDL_Renderer *ren);
 
 // Destroys an EmojiRenderer instance, freeing all associated resources.
 void emoji_renderer_destroy(EmojiRenderer *er);
 
-// Shuffles the internal list of emoji codepoints and re-renders all emojis to textures.
-// This should be called if a new set/order of emojis is desired.
-void emoji_renderer_shuffle_and_render_all(EmojiRenderer *er);
+// Shuffles the order in which emojis are presented. This only permutes indices:
+// no glyph is rendered, uploaded or released, so it is cheap enough for every resize.
+void emoji_renderer_shuffle(EmojiRenderer *er);
 
-// Gets a specific emoji texture and its original dimensions.
-// The index is into the shuffled list of available emojis.
+// Gets a specific emoji's atlas texture, its area on it, and its original dimensions.
+// The index is into the shuffled list of available emojis. The first lookup queues the
+// glyph for rasterization and returns false until emoji_renderer_pump has collected it.
 // Returns false if the index is invalid or texture is not available.
+// The area stays valid until its page is recycled, which takes more distinct emojis
+// than EMOJI_ATLAS_MAX_PAGES pages hold; see emoji_renderer_pin_pages.
 bool emoji_renderer_get_texture_info(
-    const EmojiRenderer *er, int emoji_array_idx, SDL_Texture **tex, int *w, int *h);
+    EmojiRenderer *er, int emoji_array_idx, SDL_Texture **tex, SDL_FRect *src, int *w, int *h);
+
+// Collects glyphs finished by the worker. Returns how many arrived, so the caller
+// can redraw whatever was waiting for them. Main thread only.
+int emoji_renderer_pump(EmojiRenderer *er);
+
+// True while the emoji is queued for rasterization, or waits for atlas room held by
+// pinned pages (as opposed to having failed).
+bool emoji_renderer_is_pending(const EmojiRenderer *er, int emoji_array_idx);
+
+// Pages looked up between these two calls are not recycled, so areas returned by
+// emoji_renderer_get_texture_info stay valid until quads queued against them are drawn.
+void emoji_renderer_pin_pages(EmojiRenderer *er);
+void emoji_renderer_unpin_pages(EmojiRenderer *er);
 
 // Gets the texture info for the default "blank face" emoji.
-bool emoji_renderer_get_default_texture_info(const EmojiRenderer *er, SDL_Texture **tex, int *w, int *h);
+bool emoji_renderer_get_default_texture_info(
+    const EmojiRenderer *er, SDL_Texture **tex, SDL_FRect *src, int *w, int *h);
 
-// Gets the total number of unique emojis available and rendered by this instance.
+// Gets the total number of unique emojis available by this instance.
 int emoji_renderer_get_num_emojis(const EmojiRenderer *er);
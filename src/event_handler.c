@@ -1,41 +1,66 @@
 #include "app.h"
 #include "event_handler.h"
 
+void handle_event(App *app, const SDL_Event *e)
+{
+    perf_hud_note_event(e);
+    switch (e->type) {
+        case SDL_EVENT_QUIT:
+            app->running = false;
+            break;
+        case SDL_EVENT_WINDOW_RESIZED:
+            app_notify_resize_event(app, e->window.data1, e->window.data2);
+            break;
+        case SDL_EVENT_WINDOW_DISPLAY_CHANGED:
+            frame_pacer_update_display(&app->pacer, app->win);
+            break;
+        case SDL_EVENT_WINDOW_FOCUS_LOST:
+            app_handle_focus_lost(app);
+            break;
+        case SDL_EVENT_KEY_DOWN:
+            app_handle_keydown(app, &e->key);
+            break;
+        case SDL_EVENT_KEY_UP:
+            app_handle_keyup(app, &e->key);
+            break;
+        case SDL_EVENT_MOUSE_WHEEL:
+            app_handle_mousewheel(app, &e->wheel, e->wheel.mouse_x, e->wheel.mouse_y);
+            break;
+        case SDL_EVENT_MOUSE_MOTION:
+            if (app->is_drawing) {
+                app->has_moved_since_mousedown = true;
+                app_queue_motion(app, &e->motion);
+            }
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+            app_handle_mousedown(app, &e->button);
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            app_handle_mouseup(app, &e->button);
+            break;
+    }
+}
+
 void handle_events(App *app, int sdl_wait_timeout)
 {
     SDL_Event e;
-    if (SDL_WaitEventTimeout(&e, sdl_wait_timeout)) {
+    bool have_event = SDL_WaitEventTimeout(&e, sdl_wait_timeout);
+    perf_hud_begin_work();
+    if (have_event) {
         do {
-            switch (e.type) {
-                case SDL_EVENT_QUIT:
-                    app->running = false;
-                    break;
-                case SDL_EVENT_WINDOW_RESIZED:
-                    app_notify_resize_event(app, e.window.data1, e.window.data2);
-                    break;
-                case SDL_EVENT_KEY_DOWN:
-                    app_handle_keydown(app, &e.key);
-                    break;
-                case SDL_EVENT_KEY_UP:
-                    app_handle_keyup(app, &e.key);
-                    break;
-                case SDL_EVENT_MOUSE_WHEEL:
-                    app_handle_mousewheel(app, &e.wheel, e.wheel.mouse_x, e.wheel.mouse_y);
-                    break;
-                case SDL_EVENT_MOUSE_MOTION:
-                    if (app->is_drawing) {
-                        app->has_moved_since_mousedown = true;
-                        app_draw_stroke(
-                            app, e.motion.x, e.motion.y, (e.motion.state & SDL_BUTTON_RMASK) != 0);
-                    }
-                    break;
-                case SDL_EVENT_MOUSE_BUTTON_DOWN:
-                    app_handle_mousedown(app, &e.button);
-                    break;
-                case SDL_EVENT_MOUSE_BUTTON_UP:
-                    app_handle_mouseup(app, &e.button);
-                    break;
+            if (app->recorder) {
+                replay_recorder_add(app->recorder, &e);
+            }
+            // Consecutive motion events only queue samples; they are drawn together.
+            // Anything else may depend on the canvas, so draw what is queued first.
+            if (e.type != SDL_EVENT_MOUSE_MOTION) {
+                app_flush_input(app);
             }
+            handle_event(app, &e);
         } while (SDL_PollEvent(&e)); // Process all pending events
     }
+    // Queued motion is drawn with the frame. Also on a timeout, a predicted stroke tip
+    // may be due to be taken back.
+    app_expire_prediction(app);
+    perf_hud_end_work();
 }
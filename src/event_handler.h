@@ -2,4 +2,7 @@
 
 #include "app.h"
 
+// Dispatches one event to the app; shared by the event loop and replays.
+void handle_event(App *app, const SDL_Event *e);
+
 void handle_events(App *app, int sdl_wait_timeout);
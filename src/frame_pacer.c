@@ -0,0 +1,99 @@
+#include "frame_pacer.h"
+
+static float display_refresh_hz(SDL_Window *win)
+{
+    const SDL_DisplayMode *mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(win));
+    if (!mode || mode->refresh_rate <= 0.0f) {
+        return FRAME_PACER_DEFAULT_HZ;
+    }
+    return mode->refresh_rate;
+}
+
+void frame_pacer_init(FramePacer *fp, SDL_Window *win, SDL_Renderer *ren)
+{
+    SDL_zerop(fp);
+    fp->vsync = SDL_SetRenderVSync(ren, 1);
+    if (!fp->vsync) {
+        SDL_Log("Frame pacer: VSync not available: %s", SDL_GetError());
+    }
+    frame_pacer_update_display(fp, win);
+    fp->report_ns = SDL_GetTicksNS() + FRAME_PACER_REPORT_NS;
+}
+
+void frame_pacer_update_display(FramePacer *fp, SDL_Window *win)
+{
+    float hz = display_refresh_hz(win);
+    fp->frame_ns = (Uint64)(1e9 / (double)hz);
+    SDL_Log("Frame pacer: %.2f Hz, VSync %s", (double)hz, fp->vsync ? "on" : "off");
+}
+
+void frame_pacer_request(FramePacer *fp)
+{
+    if (fp->requested_ns == 0) {
+        fp->requested_ns = SDL_GetTicksNS();
+    }
+}
+
+// The vblank after the last present, or now if that one has passed already:
+// a late frame is rendered at once rather than held back for another interval.
+static Uint64 render_at_ns(const FramePacer *fp)
+{
+    if (fp->last_present_ns == 0) {
+        return 0;
+    }
+    Uint64 lead = SDL_min(fp->render_ns + FRAME_PACER_MARGIN_NS, fp->frame_ns);
+    return fp->last_present_ns + fp->frame_ns - lead;
+}
+
+int frame_pacer_timeout_ms(const FramePacer *fp)
+{
+    Uint64 at = render_at_ns(fp);
+    Uint64 now = SDL_GetTicksNS();
+    if (at <= now) {
+        return 0;
+    }
+    return (int)((at - now + 999999) / 1000000);
+}
+
+void frame_pacer_begin_frame(FramePacer *fp)
+{
+    fp->begin_ns = SDL_GetTicksNS();
+}
+
+void frame_pacer_before_present(FramePacer *fp)
+{
+    // Exponential moving average over roughly the last eight frames.
+    Uint64 cost = SDL_GetTicksNS() - fp->begin_ns;
+    fp->render_ns = fp->render_ns ? (fp->render_ns * 7 + cost) / 8 : cost;
+}
+
+void frame_pacer_after_present(FramePacer *fp)
+{
+    Uint64 now = SDL_GetTicksNS();
+
+    // The first vblank on the grid of the last present that the frame could have made,
+    // given when it was requested and what rendering it costs.
+    if (fp->requested_ns != 0 && fp->last_present_ns != 0) {
+        Uint64 ready = fp->requested_ns + fp->render_ns;
+        Uint64 k = ready > fp->last_present_ns
+                   ? (ready - fp->last_present_ns + fp->frame_ns - 1) / fp->frame_ns
+                   : 1;
+        Uint64 expected = fp->last_present_ns + SDL_max(k, 1) * fp->frame_ns;
+        if (now > expected + fp->frame_ns / 2) {
+            fp->missed += (int)((now - expected + fp->frame_ns / 2) / fp->frame_ns);
+        }
+    }
+    ++fp->frames;
+    fp->requested_ns = 0;
+    fp->last_present_ns = now;
+
+    if (now >= fp->report_ns) {
+        if (fp->missed > 0) {
+            SDL_Log("Frame pacer: %d frames missed their vblank, %d presented since the last report",
+                    fp->missed, fp->frames);
+        }
+        fp->missed = 0;
+        fp->frames = 0;
+        fp->report_ns = now + FRAME_PACER_REPORT_NS;
+    }
+}
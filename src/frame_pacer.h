@@ -0,0 +1,47 @@
+#pragma once
+
+#define FRAME_PACER_DEFAULT_HZ 60.0f                      // When the display does not report its rate
+#define FRAME_PACER_MARGIN_NS (2 * 1000 * 1000)           // Slack between finishing a frame and vblank
+#define FRAME_PACER_REPORT_NS (5ULL * 1000 * 1000 * 1000) // How often missed frames are logged
+
+/*
+ * Schedules frames against the display's refresh.
+ *
+ * Input is handled as it arrives, but a frame is only rendered just in time to
+ * be presented at the next vblank: the frame interval minus the recent cost of
+ * rendering, minus a safety margin. A burst of events in between costs one
+ * frame, not one per event, and the frame shows the newest input there is.
+ * With VSync the present lands on the vblank; without it the same schedule
+ * still paces rendering at the refresh rate.
+ *
+ * A frame is missed when it is presented more than half an interval after the
+ * first vblank it could have made. Misses are logged periodically.
+ */
+typedef struct FramePacer {
+    Uint64 frame_ns;        // Refresh interval of the window's display
+    bool vsync;             // SDL_SetRenderVSync succeeded
+    Uint64 last_present_ns; // When the last present returned; 0 before the first
+    Uint64 requested_ns;    // When the pending frame became necessary; 0 if none is pending
+    Uint64 begin_ns;        // When rendering of the current frame started
+    Uint64 render_ns;       // Smoothed cost of rendering a frame, without the present
+    int frames;             // Presented since the last report
+    int missed;             // Missed since the last report
+    Uint64 report_ns;       // When the last report was due
+} FramePacer;
+
+// Enables VSync on ren if it can, and reads the refresh rate of win's display.
+void frame_pacer_init(FramePacer *fp, SDL_Window *win, SDL_Renderer *ren);
+
+// Rereads the refresh rate, after the window moved to another display.
+void frame_pacer_update_display(FramePacer *fp, SDL_Window *win);
+
+// Notes that there is something to draw. Repeated calls before the frame is presented are free.
+void frame_pacer_request(FramePacer *fp);
+
+// Milliseconds until the requested frame should start rendering; 0 means now.
+int frame_pacer_timeout_ms(const FramePacer *fp);
+
+// Bracket the rendering of a frame and its present.
+void frame_pacer_begin_frame(FramePacer *fp);
+void frame_pacer_before_present(FramePacer *fp);
+void frame_pacer_after_present(FramePacer *fp);
@@ -0,0 +1,249 @@
+#include "history.h"
+
+static void record_free(HistoryRecord *rec)
+{
+    for (int i = 0; i < rec->num_tiles; ++i) {
+        canvas_tile_release(rec->tiles[i].before);
+        canvas_tile_release(rec->tiles[i].after);
+    }
+    SDL_free(rec->tiles);
+    SDL_zerop(rec);
+}
+
+// Charge each record for the tiles only it keeps alive in a linear history:
+// its "before" tiles. Its "after" tiles are the live canvas or the next record's "before".
+static size_t record_bytes(const HistoryRecord *rec)
+{
+    size_t bytes = sizeof(*rec) + sizeof(HistoryTile) * rec->num_tiles;
+    for (int i = 0; i < rec->num_tiles; ++i) {
+        if (rec->tiles[i].before) {
+            bytes += sizeof(CanvasTile);
+        }
+    }
+    return bytes;
+}
+
+// Drops the oldest records until the budget is met, always keeping the newest one.
+static void history_trim(History *h)
+{
+    int drop = 0;
+    while (h->bytes > h->budget_bytes && drop < h->num_records - 1) {
+        h->bytes -= h->records[drop].bytes;
+        record_free(&h->records[drop]);
+        ++drop;
+    }
+    if (drop == 0) {
+        return;
+    }
+    SDL_memmove(h->records, h->records + drop, sizeof(*h->records) * (h->num_records - drop));
+    h->num_records -= drop;
+    h->cursor = SDL_max(h->cursor - drop, 0);
+}
+
+// Appends rec (taking ownership) after discarding everything that could be redone.
+static void history_push(History *h, HistoryRecord *rec)
+{
+    while (h->num_records > h->cursor) {
+        --h->num_records;
+        h->bytes -= h->records[h->num_records].bytes;
+        record_free(&h->records[h->num_records]);
+    }
+
+    if (h->num_records == h->max_records) {
+        int new_max = h->max_records ? h->max_records * 2 : 32;
+        HistoryRecord *records = SDL_realloc(h->records, sizeof(*records) * new_max);
+        if (!records) {
+            SDL_Log("History: Failed to grow to %d records", new_max);
+            record_free(rec);
+            return;
+        }
+        h->records = records;
+        h->max_records = new_max;
+    }
+
+    rec->bytes = record_bytes(rec);
+    h->records[h->num_records++] = *rec;
+    h->cursor = h->num_records;
+    h->bytes += rec->bytes;
+    history_trim(h);
+}
+
+size_t history_budget_from_hint(void)
+{
+    const char *value = SDL_GetHint(HISTORY_HINT_BUDGET_MB);
+    if (value && *value) {
+        char *end = NULL;
+        unsigned long mb = SDL_strtoul(value, &end, 10);
+        if (*end == '\0' && mb > 0 && mb <= SDL_SIZE_MAX / (1024 * 1024)) {
+            return (size_t)mb * 1024 * 1024;
+        }
+        SDL_Log("History: Ignoring invalid %s '%s'", HISTORY_HINT_BUDGET_MB, value);
+    }
+    return HISTORY_DEFAULT_BUDGET_BYTES;
+}
+
+void history_init(History *h, size_t budget_bytes)
+{
+    SDL_zerop(h);
+    h->budget_bytes = budget_bytes;
+}
+
+void history_free(History *h)
+{
+    if (!h) {
+        return;
+    }
+    for (int i = 0; i < h->num_records; ++i) {
+        record_free(&h->records[i]);
+    }
+    SDL_free(h->records);
+    SDL_zerop(h);
+}
+
+void history_commit_stroke(History *h, CanvasTiles *ct, SDL_Renderer *ren, SDL_Texture *canvas)
+{
+    const Uint8 changed = CANVAS_TILE_READBACK | CANVAS_TILE_SNAPSHOT;
+    int count = ct->tiles_x * ct->tiles_y;
+    int pending = 0;
+    for (int i = 0; i < count; ++i) {
+        if (ct->flags[i] & changed) {
+            ++pending;
+        }
+    }
+    if (pending == 0) {
+        return;
+    }
+
+    HistoryRecord rec;
+    SDL_zero(rec);
+    rec.tiles = SDL_malloc(sizeof(*rec.tiles) * pending);
+    if (!rec.tiles) {
+        // The CPU copy must still catch up with the canvas; only the undo step is lost.
+        SDL_Log("History: Failed to allocate record for %d tiles, stroke cannot be undone", pending);
+        canvas_tiles_forget_snapshots(ct);
+        canvas_tiles_readback(ct, ren, canvas);
+        return;
+    }
+
+    // Tiles drawn on the GPU still hold the canvas as it was before the stroke; keep
+    // them. Tiles drawn on the CPU set their old tile aside at the first write.
+    for (int i = 0; i < count; ++i) {
+        if (ct->flags[i] & changed) {
+            HistoryTile *t = &rec.tiles[rec.num_tiles++];
+            t->tx = i % ct->tiles_x;
+            t->ty = i / ct->tiles_x;
+            if (ct->flags[i] & CANVAS_TILE_SNAPSHOT) {
+                t->before = ct->snapshot[i]; // The record takes over the reference
+                ct->snapshot[i] = NULL;
+                ct->flags[i] &= ~CANVAS_TILE_SNAPSHOT;
+            } else {
+                t->before = canvas_tile_retain(ct->tiles[i]);
+            }
+        }
+    }
+
+    // Readback never writes into a shared tile, so "before" stays intact.
+    canvas_tiles_readback(ct, ren, canvas);
+
+    for (int i = 0; i < rec.num_tiles; ++i) {
+        HistoryTile *t = &rec.tiles[i];
+        t->after = canvas_tile_retain(ct->tiles[t->ty * ct->tiles_x + t->tx]);
+    }
+    rec.clear_before = ct->clear_color;
+    rec.clear_after = ct->clear_color;
+    rec.canvas_w = ct->w;
+    rec.canvas_h = ct->h;
+    history_push(h, &rec);
+}
+
+void history_commit_clear(History *h, CanvasTiles *ct, SDL_Color clear_color)
+{
+    int count = ct->tiles_x * ct->tiles_y;
+    int painted = 0;
+    for (int i = 0; i < count; ++i) {
+        if (ct->tiles[i]) {
+            ++painted;
+        }
+    }
+
+    // Clearing an empty canvas to the same color is not worth an undo step.
+    SDL_Color old = ct->clear_color;
+    if (painted == 0 && old.r == clear_color.r && old.g == clear_color.g && old.b == clear_color.b &&
+        old.a == clear_color.a) {
+        canvas_tiles_clear(ct, clear_color);
+        return;
+    }
+
+    HistoryRecord rec;
+    SDL_zero(rec);
+    rec.clear_before = ct->clear_color;
+    rec.clear_after = clear_color;
+    rec.canvas_w = ct->w;
+    rec.canvas_h = ct->h;
+    if (painted > 0) {
+        rec.tiles = SDL_malloc(sizeof(*rec.tiles) * painted);
+        if (!rec.tiles) {
+            SDL_Log("History: Failed to allocate record for %d tiles", painted);
+            canvas_tiles_clear(ct, clear_color);
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (ct->tiles[i]) {
+                HistoryTile *t = &rec.tiles[rec.num_tiles++];
+                t->tx = i % ct->tiles_x;
+                t->ty = i / ct->tiles_x;
+                t->before = canvas_tile_retain(ct->tiles[i]);
+                t->after = NULL;
+            }
+        }
+    }
+
+    canvas_tiles_clear(ct, clear_color);
+    history_push(h, &rec);
+}
+
+bool history_can_undo(const History *h)
+{
+    return h->cursor > 0;
+}
+
+bool history_can_redo(const History *h)
+{
+    return h->cursor < h->num_records;
+}
+
+static void history_apply(const HistoryRecord *rec, CanvasTiles *ct, bool undo)
+{
+    canvas_tiles_set_clear_color(ct, undo ? rec->clear_before : rec->clear_after);
+    for (int i = 0; i < rec->num_tiles; ++i) {
+        const HistoryTile *t = &rec->tiles[i];
+        if (t->tx >= ct->tiles_x || t->ty >= ct->tiles_y) {
+            continue;
+        }
+        // The canvas may have grown since; keep the area the tile did not cover clear.
+        int valid_w = SDL_min(CANVAS_TILE_SIZE, rec->canvas_w - t->tx * CANVAS_TILE_SIZE);
+        int valid_h = SDL_min(CANVAS_TILE_SIZE, rec->canvas_h - t->ty * CANVAS_TILE_SIZE);
+        canvas_tiles_set_tile_within(
+            ct, t->ty * ct->tiles_x + t->tx, undo ? t->before : t->after, valid_w, valid_h);
+    }
+}
+
+bool history_undo(History *h, CanvasTiles *ct)
+{
+    if (!history_can_undo(h)) {
+        return false;
+    }
+    --h->cursor;
+    history_apply(&h->records[h->cursor], ct, true);
+    return true;
+}
+
+bool history_redo(History *h, CanvasTiles *ct)
+{
+    if (!history_can_redo(h)) {
+        return false;
+    }
+    history_apply(&h->records[h->cursor], ct, false);
+    ++h->cursor;
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "canvas_tiles.h"
+
+#define HISTORY_DEFAULT_BUDGET_BYTES (256 * 1024 * 1024) // Oldest steps are dropped beyond this
+
+// SDL hint (or environment variable): the undo memory budget in megabytes.
+#define HISTORY_HINT_BUDGET_MB "PAINT_HISTORY_BUDGET_MB"
+
+// One tile that changed in a history step, as it was before and after.
+typedef struct HistoryTile {
+    int tx;
+    int ty;
+    CanvasTile *before; // NULL means the clear color
+    CanvasTile *after;
+} HistoryTile;
+
+// One undoable step: a stroke or a canvas clear.
+typedef struct HistoryRecord {
+    HistoryTile *tiles;
+    int num_tiles;
+    SDL_Color clear_before;
+    SDL_Color clear_after;
+    int canvas_w; // Canvas size when recorded; edge tiles hold nothing beyond it
+    int canvas_h;
+    size_t bytes; // Memory charged to this record against the budget
+} HistoryRecord;
+
+/*
+ * Undo/redo stack of tile snapshots.
+ *
+ * Records hold references to CanvasTile objects rather than copies. The
+ * "after" tiles of one step are the same objects as the "before" tiles of
+ * the next, and the tiles a stroke did not touch are never stored at all,
+ * so memory grows with the area painted rather than the canvas size.
+ */
+typedef struct History {
+    HistoryRecord *records;
+    int num_records; // Records [0, cursor) can be undone, [cursor, num_records) redone
+    int max_records;
+    int cursor;
+    size_t bytes;
+    size_t budget_bytes;
+} History;
+
+// HISTORY_HINT_BUDGET_MB if set to a positive number, else HISTORY_DEFAULT_BUDGET_BYTES.
+size_t history_budget_from_hint(void);
+
+void history_init(History *h, size_t budget_bytes);
+void history_free(History *h);
+
+// Reads back the tiles marked CANVAS_TILE_READBACK and records them, together with the
+// tiles written on the CPU (CANVAS_TILE_SNAPSHOT), as one step.
+void history_commit_stroke(History *h, CanvasTiles *ct, SDL_Renderer *ren, SDL_Texture *canvas);
+
+// Clears the canvas tiles to clear_color and records it as one step.
+void history_commit_clear(History *h, CanvasTiles *ct, SDL_Color clear_color);
+
+bool history_can_undo(const History *h);
+bool history_can_redo(const History *h);
+
+// Restore the tiles of the previous/next step and queue them for upload.
+// Tiles outside the current canvas (after a resize) are skipped.
+bool history_undo(History *h, CanvasTiles *ct);
+bool history_redo(History *h, CanvasTiles *ct);
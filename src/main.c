@@ -4,20 +4,49 @@
 #include "ui.h"
 #include "event_handler.h"
 #include "renderer.h"
+#include "replay.h"
+#include "startup_profile.h"
 
-int main(void)
+int main(int argc, char *argv[])
 {
+    // Quit as soon as the first frame is presented; for timing startup.
+    bool exit_after_first_frame = false;
+    const char *record_path = NULL; // Save the handled input events to this file
+    const char *replay_path = NULL; // Replay a recording headless, then quit
+    for (int i = 1; i < argc; ++i) {
+        if (SDL_strcmp(argv[i], "--exit-after-first-frame") == 0) {
+            exit_after_first_frame = true;
+        } else if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else {
+            SDL_Log("Unknown option: %s", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (replay_path) {
+        // Same pixels on every machine: no GPU, no window system, no background rasterizing.
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+        SDL_SetHint(EMOJI_HINT_SYNCHRONOUS, "1");
+    }
+
+    startup_profile_begin();
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         SDL_Log("SDL_Init error: %s", SDL_GetError());
         return EXIT_FAILURE;
     }
     SDL_srand(0);
+    startup_profile_mark("SDL_Init");
 
     if (!TTF_Init()) {
         SDL_Log("TTF_Init error: %s", SDL_GetError());
         SDL_Quit();
         return EXIT_FAILURE;
     }
+    startup_profile_mark("TTF_Init");
 
     SDL_Window *win = SDL_CreateWindow("Simple Paint",
                                        INITIAL_WINDOW_WIDTH,
@@ -28,6 +57,7 @@ int main(void)
         SDL_Quit();
         return EXIT_FAILURE;
     }
+    startup_profile_mark("window");
 
     SDL_Renderer *ren = SDL_CreateRenderer(win, NULL);
     if (!ren) {
@@ -36,6 +66,7 @@ int main(void)
         SDL_Quit();
         return EXIT_FAILURE;
     }
+    startup_profile_mark("renderer");
 
     // Log renderer info
     SDL_PropertiesID props = SDL_GetRendererProperties(ren);
@@ -45,7 +76,7 @@ int main(void)
 
         if (name && SDL_strcmp(name, "software") == 0) {
             SDL_Log("Warning: Renderer is NOT accelerated. "
-                    "Performance may be poor.");
+                    "Brush strokes are drawn on the CPU; other tools may be slow.");
         }
     }
 
@@ -58,29 +89,62 @@ int main(void)
         return EXIT_FAILURE;
     }
 
+    int status = EXIT_SUCCESS;
+    if (replay_path) {
+        render_scene(app);
+        app->needs_redraw = false;
+        if (!replay_run(app, replay_path)) {
+            status = EXIT_FAILURE;
+        }
+        app->running = false;
+    } else if (record_path) {
+        app->recorder = replay_recorder_open(record_path);
+        if (!app->recorder) {
+            status = EXIT_FAILURE;
+            app->running = false;
+        }
+    }
+
     while (app->running) {
         int wait_timeout;
-        if (app->needs_redraw) {
-            wait_timeout = 16;
+        if (app->needs_redraw || app_has_damage(app) || app->motion.count > 0) {
+            // Keep handling input until the frame is due.
+            frame_pacer_request(&app->pacer);
+            wait_timeout = frame_pacer_timeout_ms(&app->pacer);
         } else if (app->resize_pending) {
             wait_timeout = RESIZE_DEBOUNCE_MS / 4;
+        } else if (!SDL_RectEmpty(&app->prediction_rect)) {
+            // Wake up to take back the predicted tip if the pointer stops.
+            wait_timeout = (int)(STROKE_PREDICT_MAX_GAP_NS / 1000000);
         } else {
             wait_timeout = -1;
         }
 
         handle_events(app, wait_timeout);
+        app_collect_emoji_glyphs(app);
         app_process_debounced_resize(app);
 
-        if (app->needs_redraw) {
-            render_scene(app);
-            app->needs_redraw = false;
+        // Queued motion samples are drawn by the frame, so they also call for one.
+        if (app->needs_redraw || app_has_damage(app) || app->motion.count > 0) {
+            frame_pacer_request(&app->pacer);
+            if (frame_pacer_timeout_ms(&app->pacer) == 0) {
+                render_scene(app);
+                app->needs_redraw = false;
+
+                startup_profile_mark("first frame");
+                startup_profile_report();
+                if (exit_after_first_frame) {
+                    app->running = false;
+                }
+            }
         }
     }
 
+    replay_recorder_close(app->recorder);
     app_destroy(app);
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     TTF_Quit();
     SDL_Quit();
-    return EXIT_SUCCESS;
+    return status;
 }
@@ -0,0 +1,377 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "app.h"
+#include "draw.h"
+#include "ui.h"
+
+/*
+ * Microbenchmarks of the drawing primitives and the tools' dab functions.
+ *
+ * Runs headless against the software renderer, so results are comparable
+ * between machines without a GPU and between versions of the code. Every
+ * case runs for every canvas size and brush radius in the sweep, drawing
+ * along a path that wanders over the whole canvas. Dabs are flushed in
+ * groups of BENCH_DABS_PER_FRAME, as a frame of mouse motion would be.
+ * Results go to stdout as CSV, or JSON with --json.
+ */
+
+#define BENCH_MIN_MS 200.0        // Keep repeating a case for at least this long
+#define BENCH_MIN_ITERATIONS 64
+#define BENCH_WARMUP_ITERATIONS 8
+#define BENCH_DABS_PER_FRAME 8
+
+typedef struct BenchSize {
+    int w;
+    int h;
+} BenchSize;
+
+static const BenchSize BENCH_SIZES[] = {
+    {640, 480},
+    {1280, 720},
+    {1920, 1080},
+};
+static const int BENCH_RADII[] = {2, 8, 32, 64};
+
+typedef struct BenchState {
+    App *app;
+    float x; // Current point of the path
+    float y;
+    Uint64 sink; // Keeps callback-only work from being optimized away
+} BenchState;
+
+typedef struct BenchCase {
+    const char *name;
+    bool uses_radius; // Cases that ignore the radius run once per canvas size
+    void (*begin)(BenchState *s);
+    void (*run)(BenchState *s, float x0, float y0, float x1, float y1);
+    void (*end)(BenchState *s);
+} BenchCase;
+
+static void bench_target_canvas(BenchState *s)
+{
+    if (!SDL_SetRenderTarget(s->app->ren, s->app->canvas_texture)) {
+        SDL_Log("Bench: Failed to set canvas as target: %s", SDL_GetError());
+    }
+    if (!SDL_SetRenderDrawColor(s->app->ren, 80, 250, 123, 255)) {
+        SDL_Log("Bench: Failed to set draw color: %s", SDL_GetError());
+    }
+}
+
+static void bench_target_window(BenchState *s)
+{
+    if (!SDL_SetRenderTarget(s->app->ren, NULL)) {
+        SDL_Log("Bench: Failed to reset render target: %s", SDL_GetError());
+    }
+}
+
+static void run_draw_circle(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    draw_circle(s->app->ren, x1, y1, s->app->brush_radius);
+}
+
+static void run_draw_hollow_circle(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    draw_hollow_circle(s->app->ren, x1, y1, s->app->brush_radius);
+}
+
+static void run_draw_thick_line(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    SDL_Color color = {80, 250, 123, 255};
+    draw_thick_line(s->app->ren, x0, y0, x1, y1, s->app->brush_radius * 2, color);
+}
+
+static void bresenham_callback(int x, int y, void *userdata)
+{
+    BenchState *s = (BenchState *)userdata;
+    s->sink += (Uint64)(x ^ y);
+}
+
+// Lines across the whole canvas, from the current point to its mirror image.
+static void run_draw_line_bresenham(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    int w = s->app->canvas_texture_w;
+    int h = s->app->canvas_texture_h;
+    draw_line_bresenham((int)x1, (int)y1, w - 1 - (int)x1, h - 1 - (int)y1, bresenham_callback, s);
+}
+
+static void run_brush_segment(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    tool_brush_draw_segment(s->app, x0, y0, x1, y1);
+}
+
+static void begin_tile_raster(BenchState *s)
+{
+    // Time the CPU path even where the app draws brush strokes on the GPU.
+    if (!s->app->raster) {
+        SDL_SetHint(TILE_RASTER_HINT, "1");
+        s->app->raster = tile_raster_create(s->app->ren);
+    }
+}
+
+static void end_tile_raster(BenchState *s)
+{
+    app_sync_canvas_tiles(s->app);
+}
+
+static void run_tile_raster_segment(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    if (s->app->raster) {
+        tile_raster_add_capsule(
+            s->app->raster, x0, y0, x1, y1, (float)s->app->brush_spans.radius, s->app->current_color);
+    }
+}
+
+static void begin_water_marker(BenchState *s)
+{
+    tool_water_marker_begin_stroke(s->app);
+}
+
+static void end_water_marker(BenchState *s)
+{
+    app_flush_dab_batch(s->app);
+    tool_water_marker_end_stroke(s->app);
+    s->app->is_buffered_stroke_active = false;
+}
+
+static void run_water_marker_segment(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    tool_water_marker_draw_segment(s->app, x0, y0, x1, y1);
+}
+
+static void begin_blur(BenchState *s)
+{
+    // The blur reads the CPU copy of the canvas; bring it up to date first.
+    app_sync_canvas_tiles(s->app);
+    tool_blur_begin_stroke(s->app);
+}
+
+static void end_blur(BenchState *s)
+{
+    tool_blur_end_stroke(s->app);
+    s->app->is_buffered_stroke_active = false;
+}
+
+static void run_blur_segment(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    tool_blur_draw_line_of_dabs(s->app, x0, y0, x1, y1);
+}
+
+static void begin_emoji(BenchState *s)
+{
+    // Select the first emoji and make sure its glyph is in the atlas before timing.
+    s->app->emoji_selected_palette_idx = s->app->palette->total_color_cells;
+    tool_emoji_draw_dab(s->app, s->x, s->y);
+    app_flush_dab_batch(s->app);
+}
+
+static void run_emoji_dab(BenchState *s, float x0, float y0, float x1, float y1)
+{
+    tool_emoji_draw_dab(s->app, x1, y1);
+}
+
+static const BenchCase BENCH_CASES[] = {
+    {"draw_circle", true, bench_target_canvas, run_draw_circle, bench_target_window},
+    {"draw_hollow_circle", true, bench_target_canvas, run_draw_hollow_circle, bench_target_window},
+    {"draw_thick_line", true, bench_target_canvas, run_draw_thick_line, bench_target_window},
+    {"draw_line_bresenham", false, NULL, run_draw_line_bresenham, NULL},
+    {"tool_brush_draw_segment", true, NULL, run_brush_segment, NULL},
+    {"tile_raster_add_capsule", true, begin_tile_raster, run_tile_raster_segment, end_tile_raster},
+    {"tool_water_marker_draw_segment", true, begin_water_marker, run_water_marker_segment, end_water_marker},
+    {"tool_blur_draw_line_of_dabs", true, begin_blur, run_blur_segment, end_blur},
+    {"tool_emoji_draw_dab", true, begin_emoji, run_emoji_dab, NULL},
+};
+
+// Moves the current point by one brush radius, bouncing off the edges of the canvas.
+static void bench_step(BenchState *s, float *dx, float *dy)
+{
+    float w = (float)s->app->canvas_texture_w;
+    float h = (float)s->app->canvas_display_area_h;
+    s->x += *dx;
+    s->y += *dy;
+    if (s->x < 0.0f || s->x >= w) {
+        *dx = -*dx;
+        s->x = SDL_clamp(s->x, 0.0f, w - 1.0f);
+    }
+    if (s->y < 0.0f || s->y >= h) {
+        *dy = -*dy;
+        s->y = SDL_clamp(s->y, 0.0f, h - 1.0f);
+    }
+}
+
+// Runs iterations of one frame's worth of dabs each; returns the iteration count.
+static int bench_run_frames(BenchState *s, const BenchCase *c, int iterations, float *dx, float *dy)
+{
+    for (int i = 0; i < iterations; ++i) {
+        for (int k = 0; k < BENCH_DABS_PER_FRAME; ++k) {
+            float x0 = s->x;
+            float y0 = s->y;
+            bench_step(s, dx, dy);
+            c->run(s, x0, y0, s->x, s->y);
+        }
+        app_flush_dab_batch(s->app);
+        tool_blur_flush(s->app);
+    }
+    // The renderer queues commands; time them being executed, not just queued.
+    if (!SDL_FlushRenderer(s->app->ren)) {
+        SDL_Log("Bench: Failed to flush renderer: %s", SDL_GetError());
+    }
+    return iterations;
+}
+
+typedef struct BenchResult {
+    const char *name;
+    int canvas_w;
+    int canvas_h;
+    int radius;
+    int dabs;
+    double total_ms;
+} BenchResult;
+
+static BenchResult bench_case(BenchState *s, const BenchCase *c)
+{
+    App *app = s->app;
+    float step = (float)SDL_max(app->brush_radius, 1);
+    float dx = step * 0.8f;
+    float dy = step * 0.6f;
+    s->x = app->canvas_texture_w / 2.0f;
+    s->y = app->canvas_display_area_h / 2.0f;
+
+    if (c->begin) {
+        c->begin(s);
+    }
+    bench_run_frames(s, c, BENCH_WARMUP_ITERATIONS, &dx, &dy);
+
+    const double freq = (double)SDL_GetPerformanceFrequency();
+    int frames = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    double elapsed_ms = 0.0;
+    while (frames < BENCH_MIN_ITERATIONS || elapsed_ms < BENCH_MIN_MS) {
+        frames += bench_run_frames(s, c, BENCH_MIN_ITERATIONS / 4, &dx, &dy);
+        elapsed_ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / freq;
+    }
+
+    if (c->end) {
+        c->end(s);
+    }
+
+    BenchResult r = {
+        c->name,
+        app->canvas_texture_w,
+        app->canvas_texture_h,
+        c->uses_radius ? app->brush_radius : 0,
+        frames * BENCH_DABS_PER_FRAME,
+        elapsed_ms,
+    };
+    return r;
+}
+
+// Resizes the window and canvas right away, as the debounced resize would.
+static bool bench_resize(App *app, int w, int h)
+{
+    return app_apply_resize_now(app, w, h) && app->canvas_texture_w == w &&
+           app->canvas_texture_h == h;
+}
+
+static void print_result(const BenchResult *r, bool json, bool first)
+{
+    double ns_per_dab = r->total_ms * 1e6 / r->dabs;
+    if (json) {
+        printf("%s\n  {\"name\": \"%s\", \"canvas_w\": %d, \"canvas_h\": %d, \"radius\": %d, "
+               "\"dabs\": %d, \"total_ms\": %.3f, \"ns_per_dab\": %.1f}",
+               first ? "[" : ",", r->name, r->canvas_w, r->canvas_h, r->radius, r->dabs,
+               r->total_ms, ns_per_dab);
+    } else {
+        if (first) {
+            printf("name,canvas_w,canvas_h,radius,dabs,total_ms,ns_per_dab\n");
+        }
+        printf("%s,%d,%d,%d,%d,%.3f,%.1f\n",
+               r->name, r->canvas_w, r->canvas_h, r->radius, r->dabs, r->total_ms, ns_per_dab);
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    bool json = false;
+    const char *only = NULL; // Run only the cases whose name contains this
+    for (int i = 1; i < argc; ++i) {
+        if (SDL_strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (SDL_strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            SDL_Log("Usage: %s [--json] [--filter <name>]", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    SDL_SetHint(EMOJI_HINT_SYNCHRONOUS, "1");
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        SDL_Log("SDL_Init error: %s", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    SDL_srand(0);
+    if (!TTF_Init()) {
+        SDL_Log("TTF_Init error: %s", SDL_GetError());
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+
+    SDL_Window *win = SDL_CreateWindow("Simple Paint Bench", BENCH_SIZES[0].w, BENCH_SIZES[0].h,
+                                       SDL_WINDOW_RESIZABLE);
+    SDL_Renderer *ren = win ? SDL_CreateRenderer(win, NULL) : NULL;
+    App *app = ren ? app_create(win, ren) : NULL;
+    if (!app) {
+        SDL_Log("Bench: Failed to create the app: %s", SDL_GetError());
+        if (ren) {
+            SDL_DestroyRenderer(ren);
+        }
+        if (win) {
+            SDL_DestroyWindow(win);
+        }
+        TTF_Quit();
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+
+    BenchState state = {app, 0.0f, 0.0f, 0};
+    bool first = true;
+    for (size_t si = 0; si < SDL_arraysize(BENCH_SIZES); ++si) {
+        if (!bench_resize(app, BENCH_SIZES[si].w, BENCH_SIZES[si].h)) {
+            continue;
+        }
+        for (size_t ci = 0; ci < SDL_arraysize(BENCH_CASES); ++ci) {
+            const BenchCase *c = &BENCH_CASES[ci];
+            if (only && !SDL_strstr(c->name, only)) {
+                continue;
+            }
+            for (size_t ri = 0; ri < SDL_arraysize(BENCH_RADII); ++ri) {
+                if (!c->uses_radius && ri > 0) {
+                    break;
+                }
+                // Clear between cases so no case paints over the previous one's output.
+                app_set_background_and_clear_canvas(app, app->background_color);
+                app->brush_radius = SDL_min(BENCH_RADII[ri], app->max_brush_radius);
+                app_update_brush_spans(app);
+
+                BenchResult r = bench_case(&state, c);
+                print_result(&r, json, first);
+                first = false;
+            }
+        }
+    }
+    if (json) {
+        printf("%s]\n", first ? "[" : "\n");
+    }
+    SDL_Log("Bench: done (%" SDL_PRIu64 ")", state.sink);
+
+    app_destroy(app);
+    SDL_DestroyRenderer(ren);
+    SDL_DestroyWindow(win);
+    TTF_Quit();
+    SDL_Quit();
+    return EXIT_SUCCESS;
+}
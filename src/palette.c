@@ -1,6 +1,7 @@
 #include "color_utils.h"
 #include "ui.h"
 #include "palette.h"
+#include "startup_profile.h"
 
 /* --------------------------------------------------------------------------
    Internal helpers
@@ -113,6 +114,7 @@ Palette *palette_create(SDL_Renderer *ren, int window_w, int window_h)
         SDL_free(p);
         return NULL;
     }
+    startup_profile_mark("emoji renderer");
 
     p->colors = NULL;
     palette_recreate(p, window_w, window_h);
@@ -158,7 +160,8 @@ void palette_recreate(Palette *p, int window_w, int window_h)
     p->total_emoji_cells_to_display = p->cols * p->emoji_rows;
     p->total_cells = p->total_color_cells + p->total_emoji_cells_to_display;
 
+    // A new emoji order on every layout change; glyphs and their atlas pages are kept.
     if (p->emoji_renderer_instance) {
-        emoji_renderer_shuffle_and_render_all(p->emoji_renderer_instance);
+        emoji_renderer_shuffle(p->emoji_renderer_instance);
     }
 }
@@ -41,8 +41,9 @@ int palette_hit_test(const Palette *p,
 
 SDL_Color palette_get_color(const Palette *p, int flat_index);
 
+// The emoji is an area (src) of an atlas texture.
 bool palette_get_emoji_info(const Palette *p, int flat_index,
-                            SDL_Texture **tex, int *w, int *h);
+                            SDL_Texture **tex, SDL_FRect *src, int *w, int *h);
 
 bool palette_is_color_index(const Palette *p, int flat_index);
 bool palette_is_emoji_index(const Palette *p, int flat_index);
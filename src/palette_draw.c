@@ -1,5 +1,6 @@
 #include "ui.h"
 #include "palette.h"
+#include "perf_hud.h"
 
 static void palette_draw_colors(const Palette *p,
                                 SDL_Renderer *ren,
@@ -59,6 +60,72 @@ static void palette_draw_colors(const Palette *p,
     }
 }
 
+// Emoji glyphs of one palette redraw, collected so that every glyph on the same
+// atlas page is drawn by a single SDL_RenderGeometry call.
+typedef struct EmojiQuads {
+    SDL_Vertex *vertices; // Four per glyph
+    SDL_Texture **textures; // Atlas page of each glyph
+    int *indices;           // Scratch for the indices of one page
+    int count;
+} EmojiQuads;
+
+static void emoji_quads_add(EmojiQuads *q, SDL_Texture *tex, const SDL_FRect *src, const SDL_FRect *dst)
+{
+    float tw = 0.0f, th = 0.0f;
+    if (!SDL_GetTextureSize(tex, &tw, &th) || tw <= 0.0f || th <= 0.0f) {
+        return;
+    }
+    const float u0 = src->x / tw;
+    const float v0 = src->y / th;
+    const float u1 = (src->x + src->w) / tw;
+    const float v1 = (src->y + src->h) / th;
+    const SDL_FColor white = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    SDL_Vertex *v = &q->vertices[q->count * 4];
+    v[0] = (SDL_Vertex) {
+        {dst->x, dst->y}, white, {u0, v0}
+    };
+    v[1] = (SDL_Vertex) {
+        {dst->x + dst->w, dst->y}, white, {u1, v0}
+    };
+    v[2] = (SDL_Vertex) {
+        {dst->x + dst->w, dst->y + dst->h}, white, {u1, v1}
+    };
+    v[3] = (SDL_Vertex) {
+        {dst->x, dst->y + dst->h}, white, {u0, v1}
+    };
+    q->textures[q->count++] = tex;
+}
+
+static void emoji_quads_draw(EmojiQuads *q, SDL_Renderer *ren)
+{
+    for (int i = 0; i < q->count; ++i) {
+        SDL_Texture *tex = q->textures[i];
+        if (!tex) {
+            continue; // Already drawn with an earlier page
+        }
+        int num_indices = 0;
+        for (int j = i; j < q->count; ++j) {
+            if (q->textures[j] != tex) {
+                continue;
+            }
+            int base = j * 4;
+            int *idx = &q->indices[num_indices];
+            idx[0] = base + 0;
+            idx[1] = base + 1;
+            idx[2] = base + 3;
+            idx[3] = base + 1;
+            idx[4] = base + 2;
+            idx[5] = base + 3;
+            num_indices += 6;
+            q->textures[j] = NULL;
+        }
+        if (!perf_render_geometry(ren, tex, q->vertices, q->count * 4, q->indices, num_indices)) {
+            SDL_Log("Palette: Failed to render emoji glyphs: %s", SDL_GetError());
+        }
+    }
+}
+
 static void palette_draw_emojis(const Palette *p,
                                 SDL_Renderer *ren,
                                 int *current_y,
@@ -71,6 +138,20 @@ static void palette_draw_emojis(const Palette *p,
     int cell_width = window_w / p->cols;
     int cell_width_rem = window_w % p->cols;
 
+    int num_cells = p->emoji_rows * p->cols;
+    EmojiQuads quads = {
+        SDL_malloc(sizeof(SDL_Vertex) * 4 * num_cells),
+        SDL_malloc(sizeof(SDL_Texture *) * num_cells),
+        SDL_malloc(sizeof(int) * 6 * num_cells),
+        0,
+    };
+    if (!quads.vertices || !quads.textures || !quads.indices) {
+        SDL_Log("Palette: Failed to allocate geometry for %d emoji cells", num_cells);
+        num_available_emojis = 0;
+    }
+
+    // The quads are drawn after the loop; a page recycled before then would hold other glyphs.
+    emoji_renderer_pin_pages(p->emoji_renderer_instance);
     for (int er = 0; er < p->emoji_rows; ++er) {
         int cx = 0;
         for (int c = 0; c < p->cols; ++c) {
@@ -95,10 +176,11 @@ static void palette_draw_emojis(const Palette *p,
             if (num_available_emojis > 0) {
                 int actual_idx = grid_emoji_idx % num_available_emojis;
                 SDL_Texture *tex = NULL;
+                SDL_FRect src;
                 int tex_w = 0, tex_h = 0;
                 bool has_emoji = emoji_renderer_get_texture_info(
                                      p->emoji_renderer_instance, actual_idx,
-                                     &tex, &tex_w, &tex_h);
+                                     &tex, &src, &tex_w, &tex_h);
 
                 if (has_emoji && tex) {
                     float asp = (tex_h == 0) ? 1.0f : (float)tex_w / tex_h;
@@ -121,9 +203,8 @@ static void palette_draw_emojis(const Palette *p,
                         def_w,
                         def_h,
                     };
-                    if (!SDL_RenderTexture(ren, tex, NULL, &dst_r)) {
-                        SDL_Log("Palette: Failed to render emoji texture: %s", SDL_GetError());
-                    }
+                    // Drawn after all cells; the highlight does not overlap the glyph.
+                    emoji_quads_add(&quads, tex, &src, &dst_r);
 
                     if (f_idx == selected_idx && palette_is_emoji_index(p, f_idx)) {
                         if (!SDL_SetRenderDrawColor(ren, 189, 147, 249, 255)) { // Dracula 'Purple'
@@ -138,22 +219,23 @@ static void palette_draw_emojis(const Palette *p,
                             SDL_Log("Palette: Failed to draw inner emoji highlight: %s", SDL_GetError());
                         }
                     }
-                } else {
+                } else if (!emoji_renderer_is_pending(p->emoji_renderer_instance, actual_idx)) {
+                    // Glyphs still being rasterized leave the cell empty until they arrive.
                     if (!SDL_SetRenderDrawColor(ren, 255, 0, 0, 255)) {
                         SDL_Log("Palette: Failed to set error color: %s", SDL_GetError());
                     }
-                    if (!SDL_RenderLine(ren,
-                                        (float)cell_r.x + 5,
-                                        (float)cell_r.y + 5,
-                                        (float)cell_r.x + cell_r.w - 5,
-                                        (float)cell_r.y + cell_r.h - 5)) {
+                    if (!perf_render_line(ren,
+                                          (float)cell_r.x + 5,
+                                          (float)cell_r.y + 5,
+                                          (float)cell_r.x + cell_r.w - 5,
+                                          (float)cell_r.y + cell_r.h - 5)) {
                         SDL_Log("Palette: Failed to draw error line 1: %s", SDL_GetError());
                     }
-                    if (!SDL_RenderLine(ren,
-                                        (float)cell_r.x + cell_r.w - 5,
-                                        (float)cell_r.y + 5,
-                                        (float)cell_r.x + 5,
-                                        (float)cell_r.y + cell_r.h - 5)) {
+                    if (!perf_render_line(ren,
+                                          (float)cell_r.x + cell_r.w - 5,
+                                          (float)cell_r.y + 5,
+                                          (float)cell_r.x + 5,
+                                          (float)cell_r.y + cell_r.h - 5)) {
                         SDL_Log("Palette: Failed to draw error line 2: %s", SDL_GetError());
                     }
                 }
@@ -162,6 +244,12 @@ static void palette_draw_emojis(const Palette *p,
         }
         *current_y += PALETTE_HEIGHT;
     }
+
+    emoji_quads_draw(&quads, ren);
+    emoji_renderer_unpin_pages(p->emoji_renderer_instance);
+    SDL_free(quads.vertices);
+    SDL_free(quads.textures);
+    SDL_free(quads.indices);
 }
 
 void palette_draw(const Palette *p,
@@ -70,7 +70,7 @@ SDL_Color palette_get_color(const Palette *p, int flat_index)
 }
 
 bool palette_get_emoji_info(const Palette *p, int flat_index,
-                            SDL_Texture **tex, int *w, int *h)
+                            SDL_Texture **tex, SDL_FRect *src, int *w, int *h)
 {
     if (!palette_is_emoji_index(p, flat_index) || !p->emoji_renderer_instance) {
         return false;
@@ -82,7 +82,7 @@ bool palette_get_emoji_info(const Palette *p, int flat_index,
     }
 
     EmojiRenderer *er = p->emoji_renderer_instance;
-    return emoji_renderer_get_texture_info(er, arr_idx, tex, w, h);
+    return emoji_renderer_get_texture_info(er, arr_idx, tex, src, w, h);
 }
 
 bool palette_is_color_index(const Palette *p, int flat_index)
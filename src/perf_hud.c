@@ -0,0 +1,121 @@
+#include "perf_hud.h"
+
+#define PERF_HUD_MARGIN 8
+#define PERF_HUD_LINES 4
+#define PERF_HUD_LINE_LEN 48
+
+PerfHud perf_hud;
+
+static double ns_to_ms(Uint64 ns)
+{
+    return (double)ns / 1e6;
+}
+
+bool perf_hud_toggle(void)
+{
+#ifdef PAINT_PERF_HUD
+    perf_hud.visible = !perf_hud.visible;
+    SDL_zero(perf_hud.frame);
+    SDL_zero(perf_hud.shown);
+    perf_hud.work_start_ns = 0;
+    perf_hud.work_ns = 0;
+    perf_hud.motion_ns = 0;
+    perf_hud.frame_ms = 0.0;
+    perf_hud.latency_ms = 0.0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void perf_hud_begin_work(void)
+{
+    if (perf_hud.visible && perf_hud.work_start_ns == 0) {
+        perf_hud.work_start_ns = SDL_GetTicksNS();
+    }
+}
+
+void perf_hud_end_work(void)
+{
+    if (perf_hud.work_start_ns != 0) {
+        perf_hud.work_ns += SDL_GetTicksNS() - perf_hud.work_start_ns;
+        perf_hud.work_start_ns = 0;
+    }
+}
+
+void perf_hud_note_event(const SDL_Event *e)
+{
+    if (perf_hud.visible && e->type == SDL_EVENT_MOUSE_MOTION) {
+        perf_hud.motion_ns = e->common.timestamp;
+    }
+}
+
+void perf_hud_begin_frame(void)
+{
+    perf_hud_begin_work();
+}
+
+void perf_hud_draw(SDL_Renderer *ren)
+{
+    if (!perf_hud.visible) {
+        return;
+    }
+
+    char lines[PERF_HUD_LINES][PERF_HUD_LINE_LEN];
+    const PerfCounters *c = &perf_hud.shown;
+    SDL_snprintf(lines[0], sizeof(lines[0]), "frame   %6.2f ms", perf_hud.frame_ms);
+    SDL_snprintf(lines[1], sizeof(lines[1]), "latency %6.2f ms", perf_hud.latency_ms);
+    SDL_snprintf(lines[2], sizeof(lines[2]), "dabs %d  uploads %d", c->dabs, c->texture_uploads);
+    SDL_snprintf(lines[3], sizeof(lines[3]), "targets %d  geometry %d  lines %d",
+                 c->target_switches, c->geometry_calls, c->line_calls);
+
+    size_t max_len = 0;
+    for (int i = 0; i < PERF_HUD_LINES; ++i) {
+        max_len = SDL_max(max_len, SDL_strlen(lines[i]));
+    }
+    const float glyph = (float)SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+    const float line_h = glyph + 2.0f;
+    SDL_FRect bg = {
+        PERF_HUD_MARGIN,
+        PERF_HUD_MARGIN,
+        (float)max_len * glyph + 2.0f * PERF_HUD_MARGIN,
+        PERF_HUD_LINES * line_h + 2.0f * PERF_HUD_MARGIN,
+    };
+
+    // Dracula 'Background' at 80% opacity, 'Foreground' text.
+    if (!SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND) ||
+        !SDL_SetRenderDrawColor(ren, 40, 42, 54, 204) || !SDL_RenderFillRect(ren, &bg)) {
+        SDL_Log("PerfHud: Failed to draw background: %s", SDL_GetError());
+    }
+    if (!SDL_SetRenderDrawColor(ren, 248, 248, 242, 255)) {
+        SDL_Log("PerfHud: Failed to set text color: %s", SDL_GetError());
+    }
+    for (int i = 0; i < PERF_HUD_LINES; ++i) {
+        float y = bg.y + PERF_HUD_MARGIN + (float)i * line_h;
+        if (!SDL_RenderDebugText(ren, bg.x + PERF_HUD_MARGIN, y, lines[i])) {
+            SDL_Log("PerfHud: Failed to draw text: %s", SDL_GetError());
+            break;
+        }
+    }
+    // The rest of the frame assumes the renderer's default opaque draw blend mode.
+    if (!SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE)) {
+        SDL_Log("PerfHud: Failed to reset blend mode: %s", SDL_GetError());
+    }
+}
+
+void perf_hud_end_frame(void)
+{
+    if (!perf_hud.visible) {
+        return;
+    }
+    perf_hud_end_work();
+    perf_hud.frame_ms = ns_to_ms(perf_hud.work_ns);
+    perf_hud.work_ns = 0;
+    Uint64 now = SDL_GetTicksNS();
+    if (perf_hud.motion_ns != 0) {
+        perf_hud.latency_ms = ns_to_ms(now - perf_hud.motion_ns);
+        perf_hud.motion_ns = 0;
+    }
+    perf_hud.shown = perf_hud.frame;
+    SDL_zero(perf_hud.frame);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+/*
+ * Per-frame performance overlay, toggled with F3.
+ *
+ * The hot paths call the perf_* wrappers below instead of the SDL functions
+ * they wrap. While the overlay is hidden a wrapper costs one well-predicted
+ * branch; configured with -DPAINT_PERF_HUD=OFF the counting compiles away
+ * entirely and F3 does nothing.
+ */
+typedef struct PerfCounters {
+    int dabs;            // Stroke segments and dabs queued by the tools
+    int target_switches; // SDL_SetRenderTarget
+    int geometry_calls;  // SDL_RenderGeometry
+    int line_calls;      // SDL_RenderLine
+    int texture_uploads; // SDL_UpdateTexture
+} PerfCounters;
+
+typedef struct PerfHud {
+    bool visible;
+    PerfCounters frame;    // Counts for the frame being built
+    PerfCounters shown;    // Counts for the last presented frame
+    Uint64 work_start_ns;  // Start of the event handling or rendering under way; 0 when idle
+    Uint64 work_ns;        // Busy time since the last present, excluding waits for events
+    Uint64 motion_ns;      // Newest motion event since the last present; 0 when none
+    double frame_ms;       // Event handling and rendering of the last frame, without idle waiting
+    double latency_ms;     // From the last motion event to the present that showed it
+} PerfHud;
+
+extern PerfHud perf_hud;
+
+#ifdef PAINT_PERF_HUD
+#define PERF_COUNT(counter)               \
+    do {                                  \
+        if (perf_hud.visible) {           \
+            ++perf_hud.frame.counter;     \
+        }                                 \
+    } while (0)
+#else
+#define PERF_COUNT(counter) ((void)0)
+#endif
+
+static inline bool perf_set_render_target(SDL_Renderer *ren, SDL_Texture *tex)
+{
+    PERF_COUNT(target_switches);
+    return SDL_SetRenderTarget(ren, tex);
+}
+
+static inline bool perf_render_geometry(SDL_Renderer *ren, SDL_Texture *tex,
+                                        const SDL_Vertex *vertices, int num_vertices,
+                                        const int *indices, int num_indices)
+{
+    PERF_COUNT(geometry_calls);
+    return SDL_RenderGeometry(ren, tex, vertices, num_vertices, indices, num_indices);
+}
+
+static inline bool perf_render_line(SDL_Renderer *ren, float x1, float y1, float x2, float y2)
+{
+    PERF_COUNT(line_calls);
+    return SDL_RenderLine(ren, x1, y1, x2, y2);
+}
+
+static inline bool perf_update_texture(SDL_Texture *tex, const SDL_Rect *rect,
+                                       const void *pixels, int pitch)
+{
+    PERF_COUNT(texture_uploads);
+    return SDL_UpdateTexture(tex, rect, pixels, pitch);
+}
+
+// Shows or hides the overlay. Returns false if it is compiled out.
+bool perf_hud_toggle(void);
+
+// Bracket event handling, which starts once the wait for events returns. The frame
+// pacer may wait several times per frame; only the time in between is counted.
+void perf_hud_begin_work(void);
+void perf_hud_end_work(void);
+
+// Called for every event handled, before it is acted on.
+void perf_hud_note_event(const SDL_Event *e);
+
+// Called when rendering starts; the frame time runs until perf_hud_end_frame.
+void perf_hud_begin_frame(void);
+
+// Draws the overlay into the current render target. Call right before presenting.
+void perf_hud_draw(SDL_Renderer *ren);
+
+// Called right after presenting; closes the frame's counters and timings.
+void perf_hud_end_frame(void);
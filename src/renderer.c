@@ -1,25 +1,90 @@
 #include "renderer.h"
 #include "ui.h"
 
-void render_scene(App *app)
+// Copies the part of a window-sized texture that lies under region (the whole viewport if NULL).
+static bool render_texture_region(App *app, SDL_Texture *tex, const SDL_Rect *region)
+{
+    if (!region) {
+        return app_render_canvas_layer(app, tex);
+    }
+    SDL_FRect r;
+    SDL_RectToFRect(region, &r);
+    return SDL_RenderTexture(app->ren, tex, &r, &r);
+}
+
+// Tool selectors, separator and palette, overlaid on the bottom of the canvas.
+static void render_ui(App *app, int tool_selectors_y)
+{
+    // 3. Tool selectors "float" over the canvas, just above the main UI panel.
+    ui_draw_tool_selectors(app, tool_selectors_y);
+
+    // 4. The main UI block (palette and its separator) starts at canvas_display_area_h.
+    int current_y = app->canvas_display_area_h;
+
+    // 5. Separator between canvas/selectors and palette (if palette is visible)
+    bool is_palette_content_visible =
+        (app->show_color_palette && app->palette->color_rows > 0) ||
+        (app->show_emoji_palette && app->palette->emoji_rows > 0);
+    if (is_palette_content_visible && TOOL_SELECTOR_SEPARATOR_HEIGHT > 0) {
+        if (!SDL_SetRenderDrawColor(app->ren, 68, 71, 90, 255)) { // Dracula 'Current Line'
+            SDL_Log("Render: Failed to set color for separator: %s", SDL_GetError());
+        }
+        SDL_FRect sep_rect = {
+            0, (float)current_y, (float)app->window_w, (float)TOOL_SELECTOR_SEPARATOR_HEIGHT
+        };
+        if (!SDL_RenderFillRect(app->ren, &sep_rect)) {
+            SDL_Log("Render: Failed to fill separator: %s", SDL_GetError());
+        }
+        current_y += TOOL_SELECTOR_SEPARATOR_HEIGHT;
+    }
+
+    // 6. Palette (conditionally visible rows)
+    int active_palette_idx = app_get_current_palette_selection(app);
+    palette_draw(app->palette,
+                 app->ren,
+                 current_y,
+                 app->window_w,
+                 active_palette_idx,
+                 app->show_color_palette,
+                 app->show_emoji_palette);
+}
+
+// Composites the scene into the current render target, limited to region (or everything if NULL).
+static void render_region(App *app, const SDL_Rect *region)
 {
+    if (!SDL_SetRenderClipRect(app->ren, region)) {
+        SDL_Log("Render: Failed to set clip rect: %s", SDL_GetError());
+    }
+
     if (!SDL_SetRenderDrawColor(app->ren, 255, 255, 255, 255)) {
         SDL_Log("Failed to set draw color: %s", SDL_GetError());
     }
-    if (!SDL_RenderClear(app->ren)) {
-        SDL_Log("Failed to clear renderer: %s", SDL_GetError());
+    if (!region) {
+        if (!SDL_RenderClear(app->ren)) {
+            SDL_Log("Failed to clear renderer: %s", SDL_GetError());
+        }
+    } else {
+        // RenderClear ignores the clip rect, so only the region is filled.
+        SDL_FRect fill;
+        SDL_RectToFRect(region, &fill);
+        if (!SDL_SetRenderDrawBlendMode(app->ren, SDL_BLENDMODE_NONE)) {
+            SDL_Log("Render: Failed to set blend mode for region fill: %s", SDL_GetError());
+        }
+        if (!SDL_RenderFillRect(app->ren, &fill)) {
+            SDL_Log("Render: Failed to fill region: %s", SDL_GetError());
+        }
     }
 
     // 1. Render the canvas or active buffer.
     if (app->is_drawing && app->current_tool == TOOL_BLUR && app->is_buffered_stroke_active) {
         // For blur, the stroke_buffer is the "live" canvas. Render it directly.
-        if (!SDL_RenderTexture(app->ren, app->stroke_buffer, NULL, NULL)) {
+        if (!render_texture_region(app, app->stroke_buffer, region)) {
             SDL_Log("Failed to render stroke_buffer for blur: %s", SDL_GetError());
         }
     } else {
         // Default behavior: render the main canvas.
         if (app->canvas_texture) {
-            if (!SDL_RenderTexture(app->ren, app->canvas_texture, NULL, NULL)) {
+            if (!render_texture_region(app, app->canvas_texture, region)) {
                 SDL_Log("Failed to render canvas texture: %s", SDL_GetError());
             }
         }
@@ -27,14 +92,14 @@ void render_scene(App *app)
         // 2. Render tool previews from the stroke buffer if necessary (for non-blur tools).
         if (app->is_drawing && app->straight_line_stroke_latched && app->stroke_buffer) {
             if (app->current_tool == TOOL_BRUSH || app->current_tool == TOOL_EMOJI) {
-                if (!SDL_RenderTexture(app->ren, app->stroke_buffer, NULL, NULL)) {
+                if (!render_texture_region(app, app->stroke_buffer, region)) {
                     SDL_Log("Render: Failed to render stroke buffer preview: %s", SDL_GetError());
                 }
             } else if (app->current_tool == TOOL_WATER_MARKER) {
                 if (!SDL_SetTextureAlphaMod(app->stroke_buffer, 128)) {
                     SDL_Log("Render: Failed to set alpha for water marker preview: %s", SDL_GetError());
                 }
-                if (!SDL_RenderTexture(app->ren, app->stroke_buffer, NULL, NULL)) {
+                if (!render_texture_region(app, app->stroke_buffer, region)) {
                     SDL_Log("Render: Failed to render water marker preview: %s", SDL_GetError());
                 }
                 if (!SDL_SetTextureAlphaMod(app->stroke_buffer, 255)) {
@@ -48,54 +113,77 @@ void render_scene(App *app)
                 if (!SDL_SetTextureAlphaMod(app->stroke_buffer, 128)) {
                     SDL_Log("Render: Failed to set alpha for water marker stroke: %s", SDL_GetError());
                 }
-                if (!SDL_RenderTexture(app->ren, app->stroke_buffer, NULL, NULL)) {
+                if (!render_texture_region(app, app->stroke_buffer, region)) {
                     SDL_Log("Render: Failed to render water marker stroke: %s", SDL_GetError());
                 }
                 if (!SDL_SetTextureAlphaMod(app->stroke_buffer, 255)) { // Reset
                     SDL_Log("Render: Failed to reset alpha for water marker stroke: %s", SDL_GetError());
                 }
             }
+        } else if (app->is_drawing && !SDL_RectEmpty(&app->prediction_rect)) {
+            // The predicted tip of a brush or eraser stroke, over the real stroke.
+            if (!render_texture_region(app, app->stroke_buffer, region)) {
+                SDL_Log("Render: Failed to render predicted stroke tip: %s", SDL_GetError());
+            }
         }
     }
 
 
     // --- UI drawing from top to bottom, overlaid on the canvas ---
-
-    // 3. Tool selectors "float" over the canvas, just above the main UI panel.
+    // Skipped entirely when the region lies above the UI.
     int tool_selectors_y = app->canvas_display_area_h - TOOL_SELECTOR_AREA_HEIGHT;
-    ui_draw_tool_selectors(app, tool_selectors_y);
+    SDL_Rect ui_rect = {0, tool_selectors_y, app->window_w, app->window_h - tool_selectors_y};
+    if (!region || SDL_HasRectIntersection(region, &ui_rect)) {
+        render_ui(app, tool_selectors_y);
+    }
 
-    // 4. The main UI block (palette and its separator) starts at canvas_display_area_h.
-    int current_y = app->canvas_display_area_h;
+    if (!SDL_SetRenderClipRect(app->ren, NULL)) {
+        SDL_Log("Render: Failed to reset clip rect: %s", SDL_GetError());
+    }
+}
 
-    // 5. Separator between canvas/selectors and palette (if palette is visible)
-    bool is_palette_content_visible =
-        (app->show_color_palette && app->palette->color_rows > 0) ||
-        (app->show_emoji_palette && app->palette->emoji_rows > 0);
-    if (is_palette_content_visible && TOOL_SELECTOR_SEPARATOR_HEIGHT > 0) {
-        if (!SDL_SetRenderDrawColor(app->ren, 68, 71, 90, 255)) { // Dracula 'Current Line'
-            SDL_Log("Render: Failed to set color for separator: %s", SDL_GetError());
+void render_scene(App *app)
+{
+    perf_hud_begin_frame();
+    frame_pacer_begin_frame(&app->pacer);
+    app_flush_input(app);
+    tool_blur_flush(app);
+    if (app->canvas_texture) {
+        canvas_tiles_upload(&app->canvas_tiles, app->canvas_texture);
+    }
+
+    // Without a matching scene texture there is nothing to patch, so draw everything directly.
+    if (!app->scene_texture || app->canvas_texture_w != app->window_w ||
+        app->canvas_texture_h != app->window_h) {
+        render_region(app, NULL);
+    } else {
+        if (!perf_set_render_target(app->ren, app->scene_texture)) {
+            SDL_Log("Render: Failed to set scene texture as target: %s", SDL_GetError());
         }
-        SDL_FRect sep_rect = {
-            0, (float)current_y, (float)app->window_w, (float)TOOL_SELECTOR_SEPARATOR_HEIGHT
-        };
-        if (!SDL_RenderFillRect(app->ren, &sep_rect)) {
-            SDL_Log("Render: Failed to fill separator: %s", SDL_GetError());
+        if (app->needs_redraw) {
+            render_region(app, NULL);
+        } else {
+            for (int i = 0; i < app->damage.num_rects; ++i) {
+                render_region(app, &app->damage.rects[i]);
+            }
+        }
+        if (!perf_set_render_target(app->ren, NULL)) {
+            SDL_Log("Render: Failed to reset render target: %s", SDL_GetError());
         }
-        current_y += TOOL_SELECTOR_SEPARATOR_HEIGHT;
-    }
 
-    // 6. Palette (conditionally visible rows)
-    int active_palette_idx = app_get_current_palette_selection(app);
-    palette_draw(app->palette,
-                 app->ren,
-                 current_y,
-                 app->window_w,
-                 active_palette_idx,
-                 app->show_color_palette,
-                 app->show_emoji_palette);
+        // The back buffer is undefined after a present, so the window always gets the whole frame.
+        if (!app_render_canvas_layer(app, app->scene_texture)) {
+            SDL_Log("Render: Failed to copy scene texture: %s", SDL_GetError());
+        }
+    }
+    damage_clear(&app->damage);
 
+    // Drawn over the window only, so the scene texture never needs repairing underneath.
+    perf_hud_draw(app->ren);
+    frame_pacer_before_present(&app->pacer);
     if (!SDL_RenderPresent(app->ren)) {
         SDL_Log("SDL_RenderPresent failed: %s", SDL_GetError());
     }
+    frame_pacer_after_present(&app->pacer);
+    perf_hud_end_frame();
 }
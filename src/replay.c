@@ -0,0 +1,287 @@
+#include "app.h"
+#include "event_handler.h"
+#include "renderer.h"
+#include "replay.h"
+#include "ui.h"
+
+#define REPLAY_FNV_OFFSET 0xcbf29ce484222325ULL
+#define REPLAY_FNV_PRIME 0x100000001b3ULL
+
+typedef struct ReplayHeader {
+    char magic[4]; // "PRPL"
+    Uint32 version;
+} ReplayHeader;
+
+static bool replay_is_recorded_type(Uint32 type)
+{
+    switch (type) {
+        case SDL_EVENT_QUIT:
+        case SDL_EVENT_WINDOW_RESIZED:
+        case SDL_EVENT_WINDOW_FOCUS_LOST:
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+        case SDL_EVENT_MOUSE_WHEEL:
+        case SDL_EVENT_MOUSE_MOTION:
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+ReplayRecorder *replay_recorder_open(const char *path)
+{
+    ReplayRecorder *rec = SDL_calloc(1, sizeof(*rec));
+    if (!rec) {
+        return NULL;
+    }
+    rec->io = SDL_IOFromFile(path, "wb");
+    ReplayHeader hdr = {{'P', 'R', 'P', 'L'}, REPLAY_VERSION};
+    if (!rec->io || SDL_WriteIO(rec->io, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        SDL_Log("Replay: Failed to open '%s' for recording: %s", path, SDL_GetError());
+        if (rec->io) {
+            SDL_CloseIO(rec->io);
+        }
+        SDL_free(rec);
+        return NULL;
+    }
+    return rec;
+}
+
+void replay_recorder_add(ReplayRecorder *rec, const SDL_Event *e)
+{
+    if (!rec || !replay_is_recorded_type(e->type)) {
+        return;
+    }
+    if (rec->count == 0) {
+        rec->first_ns = e->common.timestamp;
+    }
+
+    ReplayEvent r;
+    SDL_zero(r);
+    r.time_ns = e->common.timestamp - rec->first_ns;
+    r.type = e->type;
+    switch (e->type) {
+        case SDL_EVENT_WINDOW_RESIZED:
+            r.x = (float)e->window.data1;
+            r.y = (float)e->window.data2;
+            break;
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+            r.key = e->key.key;
+            r.scancode = (Uint32)e->key.scancode;
+            r.mod = e->key.mod;
+            r.flags = (e->key.down ? REPLAY_FLAG_DOWN : 0) | (e->key.repeat ? REPLAY_FLAG_REPEAT : 0);
+            break;
+        case SDL_EVENT_MOUSE_WHEEL:
+            r.x = e->wheel.mouse_x;
+            r.y = e->wheel.mouse_y;
+            r.wheel_y = e->wheel.y;
+            break;
+        case SDL_EVENT_MOUSE_MOTION:
+            r.x = e->motion.x;
+            r.y = e->motion.y;
+            r.state = e->motion.state;
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            r.x = e->button.x;
+            r.y = e->button.y;
+            r.button = e->button.button;
+            r.flags = e->button.down ? REPLAY_FLAG_DOWN : 0;
+            break;
+        default:
+            break;
+    }
+
+    if (SDL_WriteIO(rec->io, &r, sizeof(r)) == sizeof(r)) {
+        ++rec->count;
+    }
+}
+
+void replay_recorder_close(ReplayRecorder *rec)
+{
+    if (!rec) {
+        return;
+    }
+    if (!SDL_CloseIO(rec->io)) {
+        SDL_Log("Replay: Failed to finish recording: %s", SDL_GetError());
+    }
+    SDL_Log("Replay: Recorded %d events", rec->count);
+    SDL_free(rec);
+}
+
+static void replay_to_sdl_event(const ReplayEvent *r, SDL_Event *e)
+{
+    SDL_zerop(e);
+    e->type = r->type;
+    e->common.timestamp = r->time_ns;
+    switch (r->type) {
+        case SDL_EVENT_WINDOW_RESIZED:
+            e->window.data1 = (Sint32)r->x;
+            e->window.data2 = (Sint32)r->y;
+            break;
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+            e->key.key = r->key;
+            e->key.scancode = (SDL_Scancode)r->scancode;
+            e->key.mod = r->mod;
+            e->key.down = (r->flags & REPLAY_FLAG_DOWN) != 0;
+            e->key.repeat = (r->flags & REPLAY_FLAG_REPEAT) != 0;
+            break;
+        case SDL_EVENT_MOUSE_WHEEL:
+            e->wheel.mouse_x = r->x;
+            e->wheel.mouse_y = r->y;
+            e->wheel.y = r->wheel_y;
+            break;
+        case SDL_EVENT_MOUSE_MOTION:
+            e->motion.x = r->x;
+            e->motion.y = r->y;
+            e->motion.state = r->state;
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            e->button.x = r->x;
+            e->button.y = r->y;
+            e->button.button = r->button;
+            e->button.down = (r->flags & REPLAY_FLAG_DOWN) != 0;
+            e->button.clicks = 1;
+            break;
+        default:
+            break;
+    }
+}
+
+static int compare_ticks(const void *a, const void *b)
+{
+    Uint64 x = *(const Uint64 *)a;
+    Uint64 y = *(const Uint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static void log_percentiles(const char *label, Uint64 *ticks, int count)
+{
+    if (count == 0) {
+        return;
+    }
+    SDL_qsort(ticks, (size_t)count, sizeof(*ticks), compare_ticks);
+    const double to_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    SDL_Log("Replay: %-6s n=%-6d p50 %.3f ms  p90 %.3f ms  p99 %.3f ms  max %.3f ms",
+            label,
+            count,
+            (double)ticks[count * 50 / 100] * to_ms,
+            (double)ticks[count * 90 / 100] * to_ms,
+            (double)ticks[count * 99 / 100] * to_ms,
+            (double)ticks[count - 1] * to_ms);
+}
+
+// FNV-1a over the visible canvas as RGBA bytes, independent of the texture format.
+static bool replay_canvas_hash(App *app, Uint64 *hash)
+{
+    if (!app->canvas_texture || !SDL_SetRenderTarget(app->ren, app->canvas_texture)) {
+        return false;
+    }
+    SDL_Rect r = {0, 0, app->canvas_texture_w, app->canvas_texture_h};
+    SDL_Surface *pixels = SDL_RenderReadPixels(app->ren, &r);
+    if (!SDL_SetRenderTarget(app->ren, NULL)) {
+        SDL_Log("Replay: Failed to reset render target: %s", SDL_GetError());
+    }
+    if (!pixels) {
+        return false;
+    }
+    SDL_Surface *rgba = SDL_ConvertSurface(pixels, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(pixels);
+    if (!rgba) {
+        return false;
+    }
+
+    Uint64 h = REPLAY_FNV_OFFSET;
+    for (int y = 0; y < rgba->h; ++y) {
+        const Uint8 *row = (const Uint8 *)rgba->pixels + (size_t)y * rgba->pitch;
+        for (int i = 0; i < rgba->w * 4; ++i) {
+            h = (h ^ row[i]) * REPLAY_FNV_PRIME;
+        }
+    }
+    SDL_DestroySurface(rgba);
+    *hash = h;
+    return true;
+}
+
+bool replay_run(App *app, const char *path)
+{
+    size_t size = 0;
+    Uint8 *data = SDL_LoadFile(path, &size);
+    const ReplayHeader *hdr = (const ReplayHeader *)data;
+    if (!data || size < sizeof(*hdr) || SDL_memcmp(hdr->magic, "PRPL", 4) != 0 ||
+        hdr->version != REPLAY_VERSION || (size - sizeof(*hdr)) % sizeof(ReplayEvent) != 0) {
+        SDL_Log("Replay: '%s' is not a recording of this version", path);
+        SDL_free(data);
+        return false;
+    }
+    int count = (int)((size - sizeof(*hdr)) / sizeof(ReplayEvent));
+    const ReplayEvent *events = (const ReplayEvent *)(data + sizeof(*hdr));
+
+    Uint64 *all = SDL_malloc(sizeof(Uint64) * SDL_max(count, 1));
+    Uint64 *motion = SDL_malloc(sizeof(Uint64) * SDL_max(count, 1));
+    if (!all || !motion) {
+        SDL_free(all);
+        SDL_free(motion);
+        SDL_free(data);
+        return false;
+    }
+    int num_all = 0, num_motion = 0;
+
+    // Time the work of each event, not waits for vblank.
+    if (app->pacer.vsync && SDL_SetRenderVSync(app->ren, 0)) {
+        app->pacer.vsync = false;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < count && app->running; ++i) {
+        SDL_Event e;
+        replay_to_sdl_event(&events[i], &e);
+
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        handle_event(app, &e);
+        app_flush_input(app);
+        if (e.type == SDL_EVENT_WINDOW_RESIZED) {
+            // Match the window to the recording without waiting out the debounce.
+            app_apply_resize_now(app, e.window.data1, e.window.data2);
+        }
+        if (app->needs_redraw || app_has_damage(app)) {
+            render_scene(app);
+            app->needs_redraw = false;
+        }
+        Uint64 elapsed = SDL_GetPerformanceCounter() - t0;
+
+        all[num_all++] = elapsed;
+        if (e.type == SDL_EVENT_MOUSE_MOTION) {
+            motion[num_motion++] = elapsed;
+        }
+        // The offscreen driver queues its own window events; they are not part of the replay.
+        SDL_PumpEvents();
+        SDL_FlushEvents(SDL_EVENT_FIRST, SDL_EVENT_LAST);
+    }
+    Uint64 total = SDL_GetPerformanceCounter() - start;
+
+    app_sync_canvas_tiles(app);
+    Uint64 hash = 0;
+    bool hashed = replay_canvas_hash(app, &hash);
+
+    SDL_Log("Replay: %d events in %.1f ms", num_all,
+            (double)total * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    log_percentiles("all", all, num_all);
+    log_percentiles("motion", motion, num_motion);
+    if (hashed) {
+        SDL_Log("Replay: canvas %dx%d hash %016" SDL_PRIx64,
+                app->canvas_texture_w, app->canvas_texture_h, hash);
+    } else {
+        SDL_Log("Replay: Failed to read back the canvas: %s", SDL_GetError());
+    }
+
+    SDL_free(all);
+    SDL_free(motion);
+    SDL_free(data);
+    return true;
+}
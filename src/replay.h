@@ -0,0 +1,46 @@
+#pragma once
+
+// Forward declaration; see tool.h.
+typedef struct App App;
+
+#define REPLAY_VERSION 1
+
+/*
+ * Input recordings for reproducible benchmarks.
+ *
+ * A recording is a small header followed by one fixed-size ReplayEvent per
+ * event the app handled, in native byte order. Replaying feeds the events
+ * back through handle_event one at a time, renders after each, and reports
+ * the per-event latency and a hash of the final canvas.
+ */
+typedef struct ReplayEvent {
+    Uint64 time_ns;  // Since the first recorded event
+    Uint32 type;     // SDL_EventType
+    Uint32 key;      // Key events: SDL_Keycode
+    Uint32 scancode; // Key events
+    Uint16 mod;      // Key events: SDL_Keymod
+    Uint8 button;    // Button events
+    Uint8 flags;     // REPLAY_FLAG_*
+    Uint32 state;    // Motion events: button mask
+    float x;         // Mouse position; window size for resizes
+    float y;
+    float wheel_y;   // Wheel events: vertical scroll
+} ReplayEvent;
+
+#define REPLAY_FLAG_DOWN 0x01   // Key or button pressed
+#define REPLAY_FLAG_REPEAT 0x02 // Key repeat
+
+typedef struct ReplayRecorder {
+    SDL_IOStream *io;
+    Uint64 first_ns; // Timestamp of the first recorded event
+    int count;
+} ReplayRecorder;
+
+// Starts a recording; returns NULL if the file cannot be written.
+ReplayRecorder *replay_recorder_open(const char *path);
+// Appends the event if it is of a kind handle_event acts on.
+void replay_recorder_add(ReplayRecorder *rec, const SDL_Event *e);
+void replay_recorder_close(ReplayRecorder *rec);
+
+// Replays a recording into app and logs the results. Returns false if it cannot be read.
+bool replay_run(App *app, const char *path);
@@ -0,0 +1,59 @@
+#include "spsc_ring.h"
+
+bool spsc_ring_init(SpscRing *ring, int min_capacity, size_t elem_size)
+{
+    SDL_zerop(ring);
+    Uint32 capacity = 1;
+    while (capacity < (Uint32)min_capacity) {
+        capacity <<= 1;
+    }
+    ring->slots = SDL_malloc(elem_size * capacity);
+    if (!ring->slots) {
+        SDL_Log("SpscRing: Failed to allocate %u slots", capacity);
+        return false;
+    }
+    ring->elem_size = elem_size;
+    ring->mask = capacity - 1;
+    SDL_SetAtomicInt(&ring->head, 0);
+    SDL_SetAtomicInt(&ring->tail, 0);
+    return true;
+}
+
+void spsc_ring_free(SpscRing *ring)
+{
+    if (!ring) {
+        return;
+    }
+    SDL_free(ring->slots);
+    SDL_zerop(ring);
+}
+
+bool spsc_ring_push(SpscRing *ring, const void *elem)
+{
+    // The counters wrap around; their difference is still the number of elements queued.
+    Uint32 tail = (Uint32)SDL_GetAtomicInt(&ring->tail);
+    Uint32 head = (Uint32)SDL_GetAtomicInt(&ring->head);
+    if (tail - head > ring->mask) {
+        return false;
+    }
+    SDL_memcpy(ring->slots + (tail & ring->mask) * ring->elem_size, elem, ring->elem_size);
+    // Publish the element before the index that makes it visible to the consumer.
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicInt(&ring->tail, (int)(tail + 1));
+    return true;
+}
+
+bool spsc_ring_pop(SpscRing *ring, void *elem)
+{
+    Uint32 head = (Uint32)SDL_GetAtomicInt(&ring->head);
+    Uint32 tail = (Uint32)SDL_GetAtomicInt(&ring->tail);
+    if (head == tail) {
+        return false;
+    }
+    SDL_MemoryBarrierAcquire();
+    SDL_memcpy(elem, ring->slots + (head & ring->mask) * ring->elem_size, ring->elem_size);
+    // Read the element out before handing its slot back to the producer.
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicInt(&ring->head, (int)(head + 1));
+    return true;
+}
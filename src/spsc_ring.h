@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+ * Lock-free queue of fixed-size elements between exactly one producer thread
+ * and one consumer thread. Each side only writes its own index, so no lock is
+ * needed; the capacity is fixed at init and a push into a full ring fails.
+ */
+typedef struct SpscRing {
+    Uint8 *slots;
+    size_t elem_size;
+    Uint32 mask;       // Capacity - 1; the capacity is a power of two
+    SDL_AtomicInt head; // Count of elements popped, written by the consumer only
+    SDL_AtomicInt tail; // Count of elements pushed, written by the producer only
+} SpscRing;
+
+// Creates a ring with room for at least min_capacity elements of elem_size bytes.
+bool spsc_ring_init(SpscRing *ring, int min_capacity, size_t elem_size);
+void spsc_ring_free(SpscRing *ring);
+
+// Producer side. Returns false if the ring is full.
+bool spsc_ring_push(SpscRing *ring, const void *elem);
+
+// Consumer side. Returns false if the ring is empty.
+bool spsc_ring_pop(SpscRing *ring, void *elem);
@@ -0,0 +1,56 @@
+#include "startup_profile.h"
+
+static struct {
+    Uint64 start;
+    Uint64 last;
+    const char *names[STARTUP_PROFILE_MAX_PHASES];
+    Uint64 ticks[STARTUP_PROFILE_MAX_PHASES];
+    int num_phases;
+    bool reported;
+} profile;
+
+static double ticks_to_ms(Uint64 ticks)
+{
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void startup_profile_begin(void)
+{
+    SDL_zero(profile);
+    profile.start = SDL_GetPerformanceCounter();
+    profile.last = profile.start;
+}
+
+void startup_profile_mark(const char *phase)
+{
+    if (profile.reported || profile.num_phases == STARTUP_PROFILE_MAX_PHASES) {
+        return;
+    }
+    Uint64 now = SDL_GetPerformanceCounter();
+    profile.names[profile.num_phases] = phase;
+    profile.ticks[profile.num_phases] = now - profile.last;
+    ++profile.num_phases;
+    profile.last = now;
+}
+
+void startup_profile_report(void)
+{
+    if (profile.reported) {
+        return;
+    }
+    profile.reported = true;
+
+    char line[512];
+    size_t len = 0;
+    for (int i = 0; i < profile.num_phases && len < sizeof(line); ++i) {
+        int n = SDL_snprintf(line + len, sizeof(line) - len, "%s%s %.1f ms",
+                             i ? ", " : "", profile.names[i], ticks_to_ms(profile.ticks[i]));
+        if (n < 0) {
+            break;
+        }
+        len += (size_t)n;
+    }
+    line[SDL_min(len, sizeof(line) - 1)] = '\0';
+    SDL_Log("Startup: %s", line);
+    SDL_Log("Startup: first frame after %.1f ms", ticks_to_ms(profile.last - profile.start));
+}
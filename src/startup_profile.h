@@ -0,0 +1,12 @@
+#pragma once
+
+#define STARTUP_PROFILE_MAX_PHASES 16
+
+/*
+ * Times the phases of startup with SDL_GetPerformanceCounter. Each mark ends
+ * the phase that began at the previous mark; the report logs every phase and
+ * the total in one line, once.
+ */
+void startup_profile_begin(void);
+void startup_profile_mark(const char *phase);
+void startup_profile_report(void);
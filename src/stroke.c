@@ -0,0 +1,165 @@
+#include "stroke.h"
+
+#define STROKE_SAMPLES_MIN_CAPACITY 64
+
+void stroke_reset(Stroke *s)
+{
+    SDL_zerop(s);
+}
+
+int stroke_advance(Stroke *s, float x0, float y0, float x1, float y1, float spacing,
+                   StrokeDabCallback cb, void *userdata)
+{
+    int dabs = 0;
+    if (!s->started) {
+        s->started = true;
+        s->last_x = x0;
+        s->last_y = y0;
+        s->carry = 0.0f;
+        cb(x0, y0, x0, y0, userdata);
+        ++dabs;
+    }
+
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const float len = SDL_sqrtf(dx * dx + dy * dy);
+    if (len <= 0.0f) {
+        return dabs;
+    }
+    if (spacing < STROKE_MIN_SPACING) {
+        spacing = STROKE_MIN_SPACING;
+    }
+
+    // Positions along this segment; the last dab lies behind its start by carry.
+    // If the spacing shrank since then, the first dab falls on the start itself.
+    float last_t = -s->carry;
+    for (float t = SDL_max(last_t + spacing, 0.0f); t <= len; t += spacing) {
+        float x = x0 + dx * (t / len);
+        float y = y0 + dy * (t / len);
+        cb(s->last_x, s->last_y, x, y, userdata);
+        s->last_x = x;
+        s->last_y = y;
+        last_t = t;
+        ++dabs;
+    }
+    s->carry = len - last_t;
+    return dabs;
+}
+
+void stroke_line_to(Stroke *s, float x0, float y0, float x1, float y1,
+                    StrokeDabCallback cb, void *userdata)
+{
+    if (!s->started) {
+        s->started = true;
+        s->last_x = x0;
+        s->last_y = y0;
+        cb(x0, y0, x0, y0, userdata);
+    }
+
+    if (SDL_fabsf(x1 - s->last_x) < 1e-5f && SDL_fabsf(y1 - s->last_y) < 1e-5f) {
+        return;
+    }
+    cb(s->last_x, s->last_y, x1, y1, userdata);
+    s->last_x = x1;
+    s->last_y = y1;
+    s->carry = 0.0f;
+}
+
+bool stroke_samples_push(StrokeSamples *ss, const StrokeSample *sample)
+{
+    if (ss->count == ss->capacity) {
+        int capacity = SDL_max(ss->capacity * 2, STROKE_SAMPLES_MIN_CAPACITY);
+        StrokeSample *samples = SDL_realloc(ss->samples, sizeof(*samples) * capacity);
+        if (!samples) {
+            SDL_Log("Stroke: Failed to grow sample buffer to %d", capacity);
+            return false;
+        }
+        ss->samples = samples;
+        ss->capacity = capacity;
+    }
+    ss->samples[ss->count++] = *sample;
+    return true;
+}
+
+void stroke_samples_clear(StrokeSamples *ss)
+{
+    ss->count = 0;
+}
+
+void stroke_samples_free(StrokeSamples *ss)
+{
+    if (!ss) {
+        return;
+    }
+    SDL_free(ss->samples);
+    SDL_zerop(ss);
+}
+
+void stroke_predictor_reset(StrokePredictor *p)
+{
+    SDL_zerop(p);
+}
+
+void stroke_predictor_add(StrokePredictor *p, const StrokeSample *sample)
+{
+    // Reports with the same timestamp carry no velocity; keep the newest position.
+    if (p->count > 0 && p->history[p->count - 1].timestamp_ns >= sample->timestamp_ns) {
+        p->history[p->count - 1] = *sample;
+        return;
+    }
+    if (p->count == STROKE_PREDICT_HISTORY) {
+        SDL_memmove(p->history, p->history + 1, sizeof(p->history[0]) * (STROKE_PREDICT_HISTORY - 1));
+        --p->count;
+    }
+    p->history[p->count++] = *sample;
+}
+
+static float seconds_between(const StrokeSample *a, const StrokeSample *b)
+{
+    return (float)(b->timestamp_ns - a->timestamp_ns) * 1e-9f;
+}
+
+bool stroke_predictor_predict(const StrokePredictor *p, Uint64 ahead_ns, float *x, float *y)
+{
+    if (p->count < 2) {
+        return false;
+    }
+    const StrokeSample *s1 = &p->history[p->count - 2];
+    const StrokeSample *s2 = &p->history[p->count - 1];
+    if (s2->timestamp_ns - s1->timestamp_ns > STROKE_PREDICT_MAX_GAP_NS ||
+        SDL_GetTicksNS() - s2->timestamp_ns > STROKE_PREDICT_MAX_GAP_NS) {
+        return false;
+    }
+
+    float dt = seconds_between(s1, s2);
+    float vx = (s2->x - s1->x) / dt;
+    float vy = (s2->y - s1->y) / dt;
+    float ax = 0.0f;
+    float ay = 0.0f;
+    if (p->count >= 3) {
+        const StrokeSample *s0 = &p->history[p->count - 3];
+        float dt0 = seconds_between(s0, s1);
+        if (s1->timestamp_ns - s0->timestamp_ns <= STROKE_PREDICT_MAX_GAP_NS) {
+            float v0x = (s1->x - s0->x) / dt0;
+            float v0y = (s1->y - s0->y) / dt0;
+            ax = (vx - v0x) / (0.5f * (dt0 + dt));
+            ay = (vy - v0y) / (0.5f * (dt0 + dt));
+        }
+    }
+
+    float t = (float)ahead_ns * 1e-9f;
+    float dx = vx * t + 0.5f * ax * t * t;
+    float dy = vy * t + 0.5f * ay * t * t;
+
+    // Acceleration from three noisy samples can overshoot wildly; never predict
+    // further than half again what the current speed alone would cover.
+    float limit = 1.5f * SDL_sqrtf(vx * vx + vy * vy) * t;
+    float dist = SDL_sqrtf(dx * dx + dy * dy);
+    if (dist > limit && dist > 0.0f) {
+        dx *= limit / dist;
+        dy *= limit / dist;
+    }
+    *x = s2->x + dx;
+    *y = s2->y + dy;
+    return true;
+}
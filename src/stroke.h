@@ -0,0 +1,86 @@
+#pragma once
+
+#define STROKE_DEFAULT_SPACING 0.25f // Distance between dabs as a fraction of the brush radius
+#define STROKE_MIN_SPACING 1.0f      // Never place dabs closer than this many pixels
+#define STROKE_DEFAULT_PRESSURE 1.0f // Pressure of samples from devices that do not report it
+
+// Called for every dab placed: (x0, y0) is the previous dab, (x1, y1) the new one.
+// For the first dab of a stroke both points are the same.
+typedef void (*StrokeDabCallback)(float x0, float y0, float x1, float y1, void *userdata);
+
+/*
+ * Places dabs at an even spacing along a freehand stroke.
+ *
+ * The distance travelled since the last dab is carried from one motion event to
+ * the next, so the dab density does not depend on how often the mouse reports
+ * or how fast it moves. A segment costs O(length / spacing) dabs, and the tools
+ * fill the gap between two dabs with a single shape instead of more dabs.
+ */
+typedef struct Stroke {
+    bool started;
+    float last_x; // Position of the last dab placed
+    float last_y;
+    float carry; // Distance travelled along the path since the last dab
+} Stroke;
+
+void stroke_reset(Stroke *s);
+
+// Advances the stroke from (x0, y0) to (x1, y1), calling cb for each dab placed.
+// The first call after a reset places a dab at (x0, y0). Returns the number of dabs.
+int stroke_advance(Stroke *s, float x0, float y0, float x1, float y1, float spacing,
+                   StrokeDabCallback cb, void *userdata);
+
+// Continues a stroke drawn as one polyline instead of dabs: cb joins the last vertex
+// to (x1, y1) in a single piece. The first call after a reset also places the start
+// cap at (x0, y0). Zero-length moves are dropped.
+void stroke_line_to(Stroke *s, float x0, float y0, float x1, float y1,
+                    StrokeDabCallback cb, void *userdata);
+
+// One pointer position reported while drawing.
+typedef struct StrokeSample {
+    float x;
+    float y;
+    Uint64 timestamp_ns; // Event timestamp, on the SDL_GetTicksNS clock
+    float pressure;      // 0..1; STROKE_DEFAULT_PRESSURE until pen pressure is read
+} StrokeSample;
+
+/*
+ * Pointer samples gathered between two frames, in the order they were reported.
+ *
+ * Motion events only append here; the stroke is drawn from the whole buffer at
+ * once, so the drawing work follows the frame rate rather than the report rate
+ * of the mouse, and the sub-frame timing of every sample is kept.
+ */
+typedef struct StrokeSamples {
+    StrokeSample *samples;
+    int count;
+    int capacity;
+    bool erase; // The samples belong to an eraser (right button) stroke
+} StrokeSamples;
+
+// Appends a sample; returns false if the buffer cannot grow.
+bool stroke_samples_push(StrokeSamples *ss, const StrokeSample *sample);
+void stroke_samples_clear(StrokeSamples *ss);
+void stroke_samples_free(StrokeSamples *ss);
+
+#define STROKE_PREDICT_HISTORY 3                     // Samples the predictor fits
+#define STROKE_PREDICT_AHEAD_NS (16 * 1000 * 1000)   // How far past the newest sample to predict
+#define STROKE_PREDICT_MAX_GAP_NS (50 * 1000 * 1000) // Longer pauses mean the pointer stopped
+
+/*
+ * Extrapolates where the pointer is heading from its newest samples, using their
+ * velocity and acceleration. The prediction is only a guess at what the next
+ * motion event will report; it is drawn as an overlay and replaced by the real
+ * stroke as soon as that event arrives.
+ */
+typedef struct StrokePredictor {
+    StrokeSample history[STROKE_PREDICT_HISTORY]; // Oldest first
+    int count;
+} StrokePredictor;
+
+void stroke_predictor_reset(StrokePredictor *p);
+void stroke_predictor_add(StrokePredictor *p, const StrokeSample *sample);
+
+// Predicts the position ahead_ns after the newest sample. Returns false when there
+// is not enough recent motion to go on.
+bool stroke_predictor_predict(const StrokePredictor *p, Uint64 ahead_ns, float *x, float *y);
@@ -0,0 +1,206 @@
+#include "stroke_batch.h"
+#include "perf_hud.h"
+
+#define STROKE_BATCH_MIN_QUADS 256
+
+static bool stroke_batch_reserve(StrokeBatch *batch, int extra_vertices, int extra_indices)
+{
+    if (batch->num_vertices + extra_vertices > batch->max_vertices) {
+        int new_max = batch->max_vertices ? batch->max_vertices * 2 : STROKE_BATCH_MIN_QUADS * 4;
+        while (new_max < batch->num_vertices + extra_vertices) {
+            new_max *= 2;
+        }
+        SDL_Vertex *vertices = SDL_realloc(batch->vertices, sizeof(SDL_Vertex) * new_max);
+        if (!vertices) {
+            SDL_Log("StrokeBatch: Failed to grow vertex buffer to %d vertices", new_max);
+            return false;
+        }
+        batch->vertices = vertices;
+        batch->max_vertices = new_max;
+    }
+
+    if (batch->num_indices + extra_indices > batch->max_indices) {
+        int new_max = batch->max_indices ? batch->max_indices * 2 : STROKE_BATCH_MIN_QUADS * 6;
+        while (new_max < batch->num_indices + extra_indices) {
+            new_max *= 2;
+        }
+        int *indices = SDL_realloc(batch->indices, sizeof(int) * new_max);
+        if (!indices) {
+            SDL_Log("StrokeBatch: Failed to grow index buffer to %d indices", new_max);
+            return false;
+        }
+        batch->indices = indices;
+        batch->max_indices = new_max;
+    }
+    return true;
+}
+
+static void set_vertex(SDL_Vertex *v, float x, float y, SDL_FColor color, float u, float t)
+{
+    v->position.x = x;
+    v->position.y = y;
+    v->color = color;
+    v->tex_coord.x = u;
+    v->tex_coord.y = t;
+}
+
+// Appends a convex quad (two triangles) with corners given in order around its edge.
+// The corners take the corners of uv as texture coordinates; NULL means the whole texture.
+static void stroke_batch_push_corners(
+    StrokeBatch *batch, const SDL_FPoint c[4], const SDL_FRect *uv, SDL_FColor color)
+{
+    static const SDL_FRect whole = {0.0f, 0.0f, 1.0f, 1.0f};
+    if (!uv) {
+        uv = &whole;
+    }
+    if (!stroke_batch_reserve(batch, 4, 6)) {
+        return;
+    }
+
+    int base = batch->num_vertices;
+    SDL_Vertex *v = &batch->vertices[base];
+    set_vertex(&v[0], c[0].x, c[0].y, color, uv->x, uv->y);
+    set_vertex(&v[1], c[1].x, c[1].y, color, uv->x + uv->w, uv->y);
+    set_vertex(&v[2], c[2].x, c[2].y, color, uv->x + uv->w, uv->y + uv->h);
+    set_vertex(&v[3], c[3].x, c[3].y, color, uv->x, uv->y + uv->h);
+    batch->num_vertices += 4;
+
+    int *idx = &batch->indices[batch->num_indices];
+    idx[0] = base + 0;
+    idx[1] = base + 1;
+    idx[2] = base + 3;
+    idx[3] = base + 1;
+    idx[4] = base + 2;
+    idx[5] = base + 3;
+    batch->num_indices += 6;
+}
+
+// Appends an axis-aligned quad covering [x0, x1) x [y0, y1).
+static void stroke_batch_push_quad(
+    StrokeBatch *batch, float x0, float y0, float x1, float y1, SDL_FColor color)
+{
+    const SDL_FPoint c[4] = {{x0, y0}, {x1, y0}, {x1, y1}, {x0, y1}};
+    stroke_batch_push_corners(batch, c, NULL, color);
+}
+
+void stroke_batch_init(StrokeBatch *batch)
+{
+    SDL_zerop(batch);
+}
+
+void stroke_batch_free(StrokeBatch *batch)
+{
+    if (!batch) {
+        return;
+    }
+    SDL_free(batch->vertices);
+    SDL_free(batch->indices);
+    SDL_zerop(batch);
+}
+
+bool stroke_batch_is_empty(const StrokeBatch *batch)
+{
+    return batch->num_indices == 0;
+}
+
+void stroke_batch_bind(StrokeBatch *batch, SDL_Renderer *ren, SDL_Texture *target, SDL_Texture *texture)
+{
+    if (batch->target == target && batch->texture == texture) {
+        return;
+    }
+    stroke_batch_flush(batch, ren);
+    batch->target = target;
+    batch->texture = texture;
+}
+
+void stroke_batch_flush(StrokeBatch *batch, SDL_Renderer *ren)
+{
+    if (stroke_batch_is_empty(batch)) {
+        return;
+    }
+
+    if (!perf_set_render_target(ren, batch->target)) {
+        SDL_Log("StrokeBatch: Failed to set render target: %s", SDL_GetError());
+    } else {
+        if (!batch->texture && !SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE)) {
+            SDL_Log("StrokeBatch: Failed to set blend mode: %s", SDL_GetError());
+        }
+        if (!perf_render_geometry(ren, batch->texture,
+                                  batch->vertices, batch->num_vertices,
+                                  batch->indices, batch->num_indices)) {
+            SDL_Log("StrokeBatch: SDL_RenderGeometry failed: %s", SDL_GetError());
+        }
+        if (!perf_set_render_target(ren, NULL)) {
+            SDL_Log("StrokeBatch: Failed to reset render target: %s", SDL_GetError());
+        }
+    }
+
+    batch->num_vertices = 0;
+    batch->num_indices = 0;
+}
+
+void stroke_batch_add_rect(StrokeBatch *batch, const SDL_FRect *rect, SDL_FColor color)
+{
+    stroke_batch_push_quad(batch, rect->x, rect->y, rect->x + rect->w, rect->y + rect->h, color);
+}
+
+void stroke_batch_add_sprite(
+    StrokeBatch *batch, const SDL_FRect *rect, const SDL_FRect *src, SDL_FColor color)
+{
+    float tw = 0.0f, th = 0.0f;
+    if (!batch->texture || !SDL_GetTextureSize(batch->texture, &tw, &th) || tw <= 0.0f || th <= 0.0f) {
+        stroke_batch_add_rect(batch, rect, color);
+        return;
+    }
+    const SDL_FPoint c[4] = {
+        {rect->x, rect->y},
+        {rect->x + rect->w, rect->y},
+        {rect->x + rect->w, rect->y + rect->h},
+        {rect->x, rect->y + rect->h},
+    };
+    const SDL_FRect uv = {src->x / tw, src->y / th, src->w / tw, src->h / th};
+    stroke_batch_push_corners(batch, c, &uv, color);
+}
+
+// Filled circle built from precomputed spans, matching the pixel coverage of draw_circle().
+void stroke_batch_add_circle(
+    StrokeBatch *batch, const CircleSpans *spans, float cx, float cy, SDL_FColor color)
+{
+    for (int i = 0; i < spans->num_spans; ++i) {
+        const SDL_Rect *s = &spans->spans[i];
+        stroke_batch_push_quad(batch,
+                               cx + s->x, cy + s->y,
+                               cx + s->x + s->w, cy + s->y + s->h,
+                               color);
+    }
+}
+
+void stroke_batch_add_quad(StrokeBatch *batch, const SDL_FPoint corners[4], SDL_FColor color)
+{
+    stroke_batch_push_corners(batch, corners, NULL, color);
+}
+
+void stroke_batch_add_capsule(StrokeBatch *batch, const CircleSpans *spans,
+                              float x0, float y0, float x1, float y1, SDL_FColor color)
+{
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const float len = SDL_sqrtf(dx * dx + dy * dy);
+    if (len > 0.0f) {
+        // Offset of the shaft edges from the centre line: the radius, perpendicular to it.
+        const float nx = -dy / len * spans->radius;
+        const float ny = dx / len * spans->radius;
+        // A span circle at (cx, cy) covers [cx - r, cx + r + 1), so its centre is half a
+        // pixel further on; the shaft runs between those centres to meet the round caps.
+        const float ox = 0.5f;
+        const float oy = 0.5f;
+        const SDL_FPoint c[4] = {
+            {x0 + ox + nx, y0 + oy + ny},
+            {x1 + ox + nx, y1 + oy + ny},
+            {x1 + ox - nx, y1 + oy - ny},
+            {x0 + ox - nx, y0 + oy - ny},
+        };
+        stroke_batch_push_corners(batch, c, NULL, color);
+    }
+    stroke_batch_add_circle(batch, spans, x1, y1, color);
+}
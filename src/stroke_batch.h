@@ -0,0 +1,49 @@
+#pragma once
+
+#include "draw.h"
+
+/*
+ * Accumulates the geometry of many dabs and submits it with a single
+ * SDL_RenderGeometry call, so a whole stroke segment only binds its render
+ * target once instead of switching targets for every dab.
+ */
+typedef struct StrokeBatch {
+    SDL_Vertex *vertices;
+    int num_vertices;
+    int max_vertices;
+
+    int *indices;
+    int num_indices;
+    int max_indices;
+
+    SDL_Texture *target;  // Render target the queued geometry is drawn into
+    SDL_Texture *texture; // Texture sampled by the queued geometry (NULL for solid fills)
+} StrokeBatch;
+
+void stroke_batch_init(StrokeBatch *batch);
+void stroke_batch_free(StrokeBatch *batch);
+
+// Selects the render target and texture for subsequent geometry.
+// Pending geometry for a different target or texture is flushed first.
+void stroke_batch_bind(StrokeBatch *batch, SDL_Renderer *ren, SDL_Texture *target, SDL_Texture *texture);
+
+// Draws all pending geometry into its target and resets the renderer target to the window.
+void stroke_batch_flush(StrokeBatch *batch, SDL_Renderer *ren);
+
+bool stroke_batch_is_empty(const StrokeBatch *batch);
+
+/* --- Primitives --- */
+// Quads carry 0..1 texture coordinates, so a bound texture is stretched over the rect.
+void stroke_batch_add_rect(StrokeBatch *batch, const SDL_FRect *rect, SDL_FColor color);
+// Like stroke_batch_add_rect, but samples only the src area (in pixels) of the bound texture.
+void stroke_batch_add_sprite(
+    StrokeBatch *batch, const SDL_FRect *rect, const SDL_FRect *src, SDL_FColor color);
+void stroke_batch_add_circle(
+    StrokeBatch *batch, const CircleSpans *spans, float cx, float cy, SDL_FColor color);
+// Any convex quad; corners go in order around its edge.
+void stroke_batch_add_quad(StrokeBatch *batch, const SDL_FPoint corners[4], SDL_FColor color);
+// The part of a capsule stroke that joins the dab at (x0, y0) to a new one at (x1, y1):
+// a shaft as wide as the circle plus the circle at (x1, y1). The circle at (x0, y0)
+// is expected to have been queued with the previous dab.
+void stroke_batch_add_capsule(StrokeBatch *batch, const CircleSpans *spans,
+                              float x0, float y0, float x1, float y1, SDL_FColor color);
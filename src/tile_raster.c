@@ -0,0 +1,319 @@
+#include "tile_raster.h"
+
+// Runs one job: every command touching the tile, in the order they were queued.
+static void tile_raster_run_job(const TileRaster *tr, int job)
+{
+    CanvasTile *tile = tr->job_target[job];
+    if (!tile) {
+        return;
+    }
+    SDL_Rect r = canvas_tiles_tile_rect(tr->ct, tr->job_tile[job]);
+
+    for (int k = tr->job_first[job]; k < tr->job_first[job + 1]; ++k) {
+        const TileRasterCapsule *c = &tr->commands[tr->job_commands[k]];
+        float dx = c->x1 - c->x0;
+        float dy = c->y1 - c->y0;
+        float len_sq = dx * dx + dy * dy;
+        float r_sq = c->radius * c->radius;
+
+        // Only the part of the tile inside the capsule's bounding box
+        int x0 = SDL_max(r.x, (int)SDL_floorf(SDL_min(c->x0, c->x1) - c->radius));
+        int y0 = SDL_max(r.y, (int)SDL_floorf(SDL_min(c->y0, c->y1) - c->radius));
+        int x1 = SDL_min(r.x + r.w, (int)SDL_ceilf(SDL_max(c->x0, c->x1) + c->radius) + 1);
+        int y1 = SDL_min(r.y + r.h, (int)SDL_ceilf(SDL_max(c->y0, c->y1) + c->radius) + 1);
+
+        for (int y = y0; y < y1; ++y) {
+            Uint32 *row = tile->pixels + (y - r.y) * CANVAS_TILE_SIZE;
+            float py = (float)y - c->y0;
+            for (int x = x0; x < x1; ++x) {
+                // Squared distance from the pixel to the nearest point of the segment
+                float px = (float)x - c->x0;
+                float t = len_sq > 0.0f ? SDL_clamp((px * dx + py * dy) / len_sq, 0.0f, 1.0f) : 0.0f;
+                float ex = px - t * dx;
+                float ey = py - t * dy;
+                if (ex * ex + ey * ey <= r_sq) {
+                    row[x - r.x] = c->pixel;
+                }
+            }
+        }
+    }
+}
+
+// Claims the next job of a queue, or returns -1 once it is drained.
+static int tile_raster_claim(TileRaster *tr, int queue)
+{
+    TileRasterQueue *q = &tr->queues[queue];
+    if (SDL_GetAtomicInt(&q->next) >= q->end) {
+        return -1;
+    }
+    int job = SDL_AddAtomicInt(&q->next, 1);
+    return job < q->end ? job : -1;
+}
+
+// Drains the thread's own queue, then steals from the others until all are empty.
+static void tile_raster_run_jobs(TileRaster *tr, int own)
+{
+    for (int i = 0; i < tr->num_queues; ++i) {
+        int queue = (own + i) % tr->num_queues;
+        int job;
+        while ((job = tile_raster_claim(tr, queue)) >= 0) {
+            tile_raster_run_job(tr, job);
+        }
+    }
+}
+
+static int tile_raster_worker(void *data)
+{
+    TileRaster *tr = (TileRaster *)data;
+    for (;;) {
+        SDL_WaitSemaphore(tr->start);
+        if (SDL_GetAtomicInt(&tr->quit)) {
+            break;
+        }
+        tile_raster_run_jobs(tr, SDL_AddAtomicInt(&tr->next_queue, 1));
+        SDL_SignalSemaphore(tr->done);
+    }
+    return 0;
+}
+
+TileRaster *tile_raster_create(SDL_Renderer *ren)
+{
+    const char *name = NULL;
+    SDL_PropertiesID props = SDL_GetRendererProperties(ren);
+    if (props) {
+        name = SDL_GetStringProperty(props, SDL_PROP_RENDERER_NAME_STRING, NULL);
+    }
+    bool software = name && SDL_strcmp(name, "software") == 0;
+    if (!SDL_GetHintBoolean(TILE_RASTER_HINT, software)) {
+        return NULL;
+    }
+
+    TileRaster *tr = SDL_calloc(1, sizeof(TileRaster));
+    if (!tr) {
+        SDL_Log("TileRaster: Failed to allocate rasterizer");
+        return NULL;
+    }
+    tr->start = SDL_CreateSemaphore(0);
+    tr->done = SDL_CreateSemaphore(0);
+    if (!tr->start || !tr->done) {
+        SDL_Log("TileRaster: Failed to create semaphores: %s", SDL_GetError());
+        tile_raster_destroy(tr);
+        return NULL;
+    }
+
+    // The main thread takes part in every flush, so it needs one worker fewer.
+    int count = SDL_clamp(SDL_GetNumLogicalCPUCores() - 1, 0, TILE_RASTER_MAX_THREADS);
+    SDL_SetAtomicInt(&tr->quit, 0);
+    for (int i = 0; i < count; ++i) {
+        tr->workers[i] = SDL_CreateThread(tile_raster_worker, "tile_raster", tr);
+        if (!tr->workers[i]) {
+            SDL_Log("TileRaster: Failed to start worker %d: %s", i, SDL_GetError());
+            break;
+        }
+        tr->num_workers++;
+    }
+    SDL_Log("TileRaster: Rasterizing strokes on the CPU with %d threads", tr->num_workers + 1);
+    return tr;
+}
+
+void tile_raster_destroy(TileRaster *tr)
+{
+    if (!tr) {
+        return;
+    }
+    SDL_SetAtomicInt(&tr->quit, 1);
+    for (int i = 0; i < tr->num_workers; ++i) {
+        SDL_SignalSemaphore(tr->start);
+    }
+    for (int i = 0; i < tr->num_workers; ++i) {
+        SDL_WaitThread(tr->workers[i], NULL);
+    }
+    if (tr->start) {
+        SDL_DestroySemaphore(tr->start);
+    }
+    if (tr->done) {
+        SDL_DestroySemaphore(tr->done);
+    }
+    SDL_free(tr->commands);
+    SDL_free(tr->tile_cursor);
+    SDL_free(tr->job_tile);
+    SDL_free(tr->job_first);
+    SDL_free(tr->job_target);
+    SDL_free(tr->job_commands);
+    SDL_free(tr);
+}
+
+void tile_raster_add_capsule(TileRaster *tr, float x0, float y0, float x1, float y1,
+                             float radius, SDL_Color color)
+{
+    if (tr->num_commands == tr->max_commands) {
+        int max = tr->max_commands ? tr->max_commands * 2 : TILE_RASTER_MIN_COMMANDS;
+        TileRasterCapsule *commands = SDL_realloc(tr->commands, sizeof(*commands) * max);
+        if (!commands) {
+            SDL_Log("TileRaster: Failed to grow command buffer to %d", max);
+            return;
+        }
+        tr->commands = commands;
+        tr->max_commands = max;
+    }
+    tr->commands[tr->num_commands++] = (TileRasterCapsule){
+        x0,
+        y0,
+        x1,
+        y1,
+        radius,
+        SDL_MapRGBA(SDL_GetPixelFormatDetails(CANVAS_TILE_FORMAT), NULL, color.r, color.g, color.b, color.a),
+    };
+}
+
+// Sizes the per-tile and per-job arrays for the canvas; they only change on resize.
+static bool tile_raster_reserve_tiles(TileRaster *tr, int num_tiles)
+{
+    if (tr->num_tiles == num_tiles) {
+        return true;
+    }
+    SDL_free(tr->tile_cursor);
+    SDL_free(tr->job_tile);
+    SDL_free(tr->job_first);
+    SDL_free(tr->job_target);
+    tr->tile_cursor = SDL_calloc(num_tiles, sizeof(int));
+    tr->job_tile = SDL_malloc(sizeof(int) * num_tiles);
+    tr->job_first = SDL_malloc(sizeof(int) * (num_tiles + 1));
+    tr->job_target = SDL_malloc(sizeof(CanvasTile *) * num_tiles);
+    if (!tr->tile_cursor || !tr->job_tile || !tr->job_first || !tr->job_target) {
+        SDL_Log("TileRaster: Failed to allocate bins for %d tiles", num_tiles);
+        tr->num_tiles = 0;
+        return false;
+    }
+    tr->num_tiles = num_tiles;
+    return true;
+}
+
+// Range of tiles a command overlaps; false if it lies outside the canvas.
+static bool tile_raster_command_tiles(const CanvasTiles *ct, const TileRasterCapsule *c, SDL_Rect *out)
+{
+    int x0 = (int)SDL_floorf(SDL_min(c->x0, c->x1) - c->radius);
+    int y0 = (int)SDL_floorf(SDL_min(c->y0, c->y1) - c->radius);
+    int x1 = (int)SDL_ceilf(SDL_max(c->x0, c->x1) + c->radius);
+    int y1 = (int)SDL_ceilf(SDL_max(c->y0, c->y1) + c->radius);
+    if (x1 < 0 || y1 < 0 || x0 >= ct->w || y0 >= ct->h) {
+        return false;
+    }
+    out->x = SDL_max(x0, 0) / CANVAS_TILE_SIZE;
+    out->y = SDL_max(y0, 0) / CANVAS_TILE_SIZE;
+    out->w = SDL_min(x1, ct->w - 1) / CANVAS_TILE_SIZE - out->x + 1;
+    out->h = SDL_min(y1, ct->h - 1) / CANVAS_TILE_SIZE - out->y + 1;
+    return true;
+}
+
+// Groups the command indices by tile with a counting sort, which keeps them in
+// queue order within each tile. Returns false if out of memory.
+static bool tile_raster_bin(TileRaster *tr, const CanvasTiles *ct)
+{
+    int total = 0;
+    for (int i = 0; i < tr->num_commands; ++i) {
+        SDL_Rect t;
+        if (!tile_raster_command_tiles(ct, &tr->commands[i], &t)) {
+            continue;
+        }
+        for (int ty = t.y; ty < t.y + t.h; ++ty) {
+            for (int tx = t.x; tx < t.x + t.w; ++tx) {
+                tr->tile_cursor[ty * ct->tiles_x + tx]++;
+            }
+        }
+        total += t.w * t.h;
+    }
+
+    if (total > tr->max_job_commands) {
+        int *job_commands = SDL_realloc(tr->job_commands, sizeof(int) * total);
+        if (!job_commands) {
+            SDL_Log("TileRaster: Failed to allocate %d binned commands", total);
+            SDL_memset(tr->tile_cursor, 0, sizeof(int) * tr->num_tiles);
+            return false;
+        }
+        tr->job_commands = job_commands;
+        tr->max_job_commands = total;
+    }
+
+    // Every touched tile becomes a job; its count turns into its write position.
+    tr->num_jobs = 0;
+    int offset = 0;
+    for (int i = 0; i < tr->num_tiles; ++i) {
+        if (tr->tile_cursor[i] == 0) {
+            continue;
+        }
+        tr->job_tile[tr->num_jobs] = i;
+        tr->job_first[tr->num_jobs] = offset;
+        offset += tr->tile_cursor[i];
+        tr->tile_cursor[i] = tr->job_first[tr->num_jobs];
+        tr->num_jobs++;
+    }
+    tr->job_first[tr->num_jobs] = offset;
+
+    for (int i = 0; i < tr->num_commands; ++i) {
+        SDL_Rect t;
+        if (!tile_raster_command_tiles(ct, &tr->commands[i], &t)) {
+            continue;
+        }
+        for (int ty = t.y; ty < t.y + t.h; ++ty) {
+            for (int tx = t.x; tx < t.x + t.w; ++tx) {
+                tr->job_commands[tr->tile_cursor[ty * ct->tiles_x + tx]++] = i;
+            }
+        }
+    }
+    for (int j = 0; j < tr->num_jobs; ++j) {
+        tr->tile_cursor[tr->job_tile[j]] = 0;
+    }
+    return true;
+}
+
+// True if a job's tile holds GPU drawing the CPU copy does not have yet.
+static bool tile_raster_needs_readback(const TileRaster *tr, const CanvasTiles *ct)
+{
+    for (int j = 0; j < tr->num_jobs; ++j) {
+        if (ct->flags[tr->job_tile[j]] & CANVAS_TILE_READBACK) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void tile_raster_flush(TileRaster *tr, CanvasTiles *ct, SDL_Renderer *ren, SDL_Texture *canvas)
+{
+    if (!tr || tr->num_commands == 0) {
+        return;
+    }
+    if (!tile_raster_reserve_tiles(tr, ct->tiles_x * ct->tiles_y) || !tile_raster_bin(tr, ct)) {
+        tr->num_commands = 0;
+        return;
+    }
+    tr->ct = ct;
+
+    // E.g. erasing over emoji dabs of the same stroke: the CPU copy of those is stale.
+    if (canvas && tile_raster_needs_readback(tr, ct)) {
+        canvas_tiles_readback_for_write(ct, ren, canvas);
+    }
+
+    // Copy-on-write and the history snapshot both touch shared state; do them here.
+    for (int j = 0; j < tr->num_jobs; ++j) {
+        tr->job_target[j] = canvas_tiles_write_tile(ct, tr->job_tile[j]);
+    }
+
+    // Small flushes are not worth waking the pool for.
+    int threads = SDL_clamp(tr->num_jobs / TILE_RASTER_MIN_JOBS_PER_THREAD, 1, tr->num_workers + 1);
+    tr->num_queues = threads;
+    for (int q = 0; q < threads; ++q) {
+        SDL_SetAtomicInt(&tr->queues[q].next, tr->num_jobs * q / threads);
+        tr->queues[q].end = tr->num_jobs * (q + 1) / threads;
+    }
+    SDL_SetAtomicInt(&tr->next_queue, 0);
+    for (int i = 1; i < threads; ++i) {
+        SDL_SignalSemaphore(tr->start);
+    }
+    tile_raster_run_jobs(tr, threads - 1);
+    for (int i = 1; i < threads; ++i) {
+        SDL_WaitSemaphore(tr->done);
+    }
+
+    tr->num_commands = 0;
+}
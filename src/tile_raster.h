@@ -0,0 +1,76 @@
+#pragma once
+
+#include "canvas_tiles.h"
+
+#define TILE_RASTER_MAX_THREADS 16
+#define TILE_RASTER_MIN_JOBS_PER_THREAD 4 // Smaller flushes use fewer threads
+#define TILE_RASTER_MIN_COMMANDS 64 // Initial command buffer size
+
+// SDL hint: "1" rasterizes brush and eraser strokes into the CPU tiles even on an
+// accelerated renderer, "0" never does. By default only the software renderer does.
+#define TILE_RASTER_HINT "PAINT_CPU_RASTER"
+
+// A round-capped segment of solid color: a dab when both ends are the same point.
+typedef struct TileRasterCapsule {
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+    float radius;
+    Uint32 pixel; // In CANVAS_TILE_FORMAT
+} TileRasterCapsule;
+
+// One worker's share of the tile jobs of a flush. The owner and idle thieves
+// alike claim jobs by atomically advancing next, so a job runs exactly once.
+typedef struct TileRasterQueue {
+    SDL_AtomicInt next;
+    int end;
+} TileRasterQueue;
+
+/*
+ * Multithreaded rasterizer that draws straight into the CPU canvas tiles.
+ *
+ * With the software renderer every SDL draw call runs on the main thread.
+ * Here dabs are only queued as commands; a flush bins them by the tiles they
+ * overlap and hands each touched tile to the pool as one job. A job applies
+ * its tile's commands in the order they were queued, so the result does not
+ * depend on the number of threads. Each thread starts on its own contiguous
+ * run of tiles and steals from the others once that is done. The tiles are
+ * queued for upload and reach the canvas texture once per frame.
+ */
+typedef struct TileRaster {
+    TileRasterCapsule *commands;
+    int num_commands;
+    int max_commands;
+
+    // Binning of the flush in progress, sized for the canvas
+    int num_tiles;
+    int *tile_cursor;        // Per tile: command count, then where its next index goes
+    int *job_tile;           // Per job: tile index
+    int *job_first;          // Per job: offset of its commands in job_commands; one extra
+    CanvasTile **job_target; // Per job: the writable tile
+    int *job_commands;       // Command indices, grouped by job in queue order
+    int max_job_commands;
+    int num_jobs;
+    const CanvasTiles *ct;
+
+    SDL_Thread *workers[TILE_RASTER_MAX_THREADS];
+    int num_workers;                                     // Threads besides the main one
+    TileRasterQueue queues[TILE_RASTER_MAX_THREADS + 1]; // One per thread taking part
+    int num_queues;                                      // Threads taking part in this flush
+    SDL_AtomicInt next_queue;                            // Hands each woken worker its queue
+    SDL_Semaphore *start;
+    SDL_Semaphore *done;
+    SDL_AtomicInt quit;
+} TileRaster;
+
+// Returns NULL if the rasterizer is not wanted for this renderer or cannot start.
+TileRaster *tile_raster_create(SDL_Renderer *ren);
+void tile_raster_destroy(TileRaster *tr);
+
+void tile_raster_add_capsule(TileRaster *tr, float x0, float y0, float x1, float y1,
+                             float radius, SDL_Color color);
+
+// Rasterizes the queued commands into ct and queues the touched tiles for upload.
+// Touched tiles that were drawn on the GPU are read back from canvas first.
+void tile_raster_flush(TileRaster *tr, CanvasTiles *ct, SDL_Renderer *ren, SDL_Texture *canvas);
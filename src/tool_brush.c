@@ -1,21 +1,17 @@
 #include "app.h"
+#include "color_utils.h"
 #include "ui.h"
 #include "draw.h"
 
-void tool_brush_draw_dab(App *app, int x, int y)
+// Queues the capsule from the dab at (x0, y0) to a new one at (x1, y1) into the app's
+// stroke batch; it is drawn when the batch is flushed.
+void tool_brush_draw_segment(App *app, float x0, float y0, float x1, float y1)
 {
-    if (!SDL_SetRenderTarget(app->ren, app->canvas_texture)) {
-        SDL_Log("Brush: Failed to set render target: %s", SDL_GetError());
-        return;
-    }
-    if (!SDL_SetRenderDrawColor(
-            app->ren, app->current_color.r, app->current_color.g, app->current_color.b, 255)) {
-        SDL_Log("Brush: Failed to set draw color: %s", SDL_GetError());
-    }
-    draw_circle(app->ren, (float)x, (float)y, app->brush_radius);
-    if (!SDL_SetRenderTarget(app->ren, NULL)) {
-        SDL_Log("Brush: Failed to reset render target: %s", SDL_GetError());
-    }
+    SDL_Color color = app->current_color;
+    color.a = 255;
+    stroke_batch_bind(&app->dab_batch, app->ren, app->canvas_texture, NULL);
+    stroke_batch_add_capsule(
+        &app->dab_batch, &app->brush_spans, x0, y0, x1, y1, color_to_fcolor(color));
 }
 
 void tool_brush_draw_line_preview(App *app, float x0, float y0, float x1, float y1)
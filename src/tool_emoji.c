@@ -4,10 +4,11 @@
 static void draw_line_of_emojis(App *app, float x0, float y0, float x1, float y1)
 {
     SDL_Texture *emoji_tex = NULL;
+    SDL_FRect src;
     int ew = 0, eh = 0;
     bool has_emoji = palette_get_emoji_info(
                          app->palette, app->emoji_selected_palette_idx,
-                         &emoji_tex, &ew, &eh);
+                         &emoji_tex, &src, &ew, &eh);
 
     if (!has_emoji || !emoji_tex) {
         return;
@@ -28,7 +29,7 @@ static void draw_line_of_emojis(App *app, float x0, float y0, float x1, float y1
 
     // Draw first emoji at the start point
     SDL_FRect dst_start = {x0 - w / 2.0f, y0 - h / 2.0f, (float)w, (float)h};
-    if (!SDL_RenderTexture(app->ren, emoji_tex, NULL, &dst_start)) {
+    if (!SDL_RenderTexture(app->ren, emoji_tex, &src, &dst_start)) {
         SDL_Log("Emoji: Failed to render start emoji: %s", SDL_GetError());
     }
 
@@ -49,23 +50,21 @@ static void draw_line_of_emojis(App *app, float x0, float y0, float x1, float y1
         float px = x0 + (float)i * h * ux;
         float py = y0 + (float)i * h * uy;
         SDL_FRect dst = {px - w / 2.0f, py - h / 2.0f, (float)w, (float)h};
-        if (!SDL_RenderTexture(app->ren, emoji_tex, NULL, &dst)) {
+        if (!SDL_RenderTexture(app->ren, emoji_tex, &src, &dst)) {
             SDL_Log("Emoji: Failed to render line emoji: %s", SDL_GetError());
         }
     }
 }
 
-void tool_emoji_draw_dab(App *app, int x, int y)
+// Queues the dab into the app's stroke batch; it is drawn when the batch is flushed.
+void tool_emoji_draw_dab(App *app, float x, float y)
 {
-    if (!SDL_SetRenderTarget(app->ren, app->canvas_texture)) {
-        SDL_Log("Emoji: Failed to set render target for dab: %s", SDL_GetError());
-        return;
-    }
     SDL_Texture *emoji_tex = NULL;
+    SDL_FRect src;
     int ew = 0, eh = 0;
     bool has_emoji = palette_get_emoji_info(
                          app->palette, app->emoji_selected_palette_idx,
-                         &emoji_tex, &ew, &eh);
+                         &emoji_tex, &src, &ew, &eh);
     if (has_emoji && emoji_tex) {
         float asp = (eh == 0) ? 1.0f : (float)ew / eh;
         int h = app->brush_radius * 6;
@@ -77,13 +76,10 @@ void tool_emoji_draw_dab(App *app, int x, int y)
             w = 1;
         }
 
-        SDL_FRect dst = {(float)x - w / 2.0f, (float)y - h / 2.0f, (float)w, (float)h};
-        if (!SDL_RenderTexture(app->ren, emoji_tex, NULL, &dst)) {
-            SDL_Log("Emoji: Failed to render dab texture: %s", SDL_GetError());
-        }
-    }
-    if (!SDL_SetRenderTarget(app->ren, NULL)) {
-        SDL_Log("Emoji: Failed to reset render target after dab: %s", SDL_GetError());
+        SDL_FRect dst = {x - w / 2.0f, y - h / 2.0f, (float)w, (float)h};
+        SDL_FColor white = {1.0f, 1.0f, 1.0f, 1.0f};
+        stroke_batch_bind(&app->dab_batch, app->ren, app->canvas_texture, emoji_tex);
+        stroke_batch_add_sprite(&app->dab_batch, &dst, &src, white);
     }
 }
 
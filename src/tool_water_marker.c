@@ -1,4 +1,5 @@
 #include "app.h"
+#include "color_utils.h"
 #include "draw.h"
 
 void tool_water_marker_begin_stroke(App *app)
@@ -9,7 +10,7 @@ void tool_water_marker_begin_stroke(App *app)
     app->is_buffered_stroke_active = true;
 
     // Clear the buffer to be fully transparent for the new stroke
-    if (!SDL_SetRenderTarget(app->ren, app->stroke_buffer)) {
+    if (!perf_set_render_target(app->ren, app->stroke_buffer)) {
         SDL_Log("Water: Failed to set render target to stroke buffer: %s", SDL_GetError());
         return;
     }
@@ -22,7 +23,7 @@ void tool_water_marker_begin_stroke(App *app)
     if (!SDL_RenderClear(app->ren)) {
         SDL_Log("Water: Failed to clear stroke buffer: %s", SDL_GetError());
     }
-    if (!SDL_SetRenderTarget(app->ren, NULL)) {
+    if (!perf_set_render_target(app->ren, NULL)) {
         SDL_Log("Water: Failed to reset render target: %s", SDL_GetError());
     }
 }
@@ -33,8 +34,10 @@ void tool_water_marker_end_stroke(App *app)
         return;
     }
 
-    // Blend the completed stroke from the buffer onto the main canvas
-    if (!SDL_SetRenderTarget(app->ren, app->canvas_texture)) {
+    // Blend the completed stroke from the buffer onto the main canvas, over any
+    // CPU-drawn tiles still waiting for upload.
+    app_upload_canvas_tiles(app, NULL);
+    if (!perf_set_render_target(app->ren, app->canvas_texture)) {
         SDL_Log("Water: Failed to set render target to canvas: %s", SDL_GetError());
         return;
     }
@@ -44,7 +47,7 @@ void tool_water_marker_end_stroke(App *app)
     if (!SDL_SetTextureAlphaMod(app->stroke_buffer, 128)) { // 50% alpha
         SDL_Log("Water: Failed to set alpha mod for stroke buffer: %s", SDL_GetError());
     }
-    if (!SDL_RenderTexture(app->ren, app->stroke_buffer, NULL, NULL)) {
+    if (!app_render_canvas_layer(app, app->stroke_buffer)) {
         SDL_Log("Water: Failed to render stroke buffer to canvas: %s", SDL_GetError());
     }
 
@@ -52,37 +55,43 @@ void tool_water_marker_end_stroke(App *app)
     if (!SDL_SetTextureAlphaMod(app->stroke_buffer, 255)) {
         SDL_Log("Water: Failed to reset alpha mod: %s", SDL_GetError());
     }
-    if (!SDL_SetRenderTarget(app->ren, NULL)) {
+    if (!perf_set_render_target(app->ren, NULL)) {
         SDL_Log("Water: Failed to reset render target: %s", SDL_GetError());
     }
 
     app->needs_redraw = true;
 }
 
-void tool_water_marker_draw_dab(App *app, int x, int y)
+// Queues the square dab at (x1, y1) and the band it sweeps from the dab at (x0, y0)
+// into the app's stroke batch; it is drawn when the batch is flushed.
+void tool_water_marker_draw_segment(App *app, float x0, float y0, float x1, float y1)
 {
     if (!app->is_buffered_stroke_active || !app->stroke_buffer) {
         return; // Not in a stroke, do nothing
     }
-    if (!SDL_SetRenderTarget(app->ren, app->stroke_buffer)) {
-        SDL_Log("Water: Failed to set RT for dab: %s", SDL_GetError());
-        return;
-    }
-    if (!SDL_SetRenderDrawColor(app->ren,
-                                app->water_marker_color.r,
-                                app->water_marker_color.g,
-                                app->water_marker_color.b,
-                                255)) {
-        SDL_Log("Water: Failed to set color for dab: %s", SDL_GetError());
-    }
+    SDL_Color color = app->water_marker_color;
+    color.a = 255;
+    SDL_FColor fcolor = color_to_fcolor(color);
     int side = (int)SDL_lroundf(app->brush_radius * 2 * 1.5f);
-    SDL_FRect rect = {(float)x - side / 2.0f, (float)y - side / 2.0f, (float)side, (float)side};
-    if (!SDL_RenderFillRect(app->ren, &rect)) {
-        SDL_Log("Water: Failed to draw dab rect: %s", SDL_GetError());
-    }
-    if (!SDL_SetRenderTarget(app->ren, NULL)) {
-        SDL_Log("Water: Failed to reset RT after dab: %s", SDL_GetError());
+    float half = side / 2.0f;
+    stroke_batch_bind(&app->dab_batch, app->ren, app->stroke_buffer, NULL);
+
+    // A square moved along a segment covers both end squares plus the parallelogram
+    // spanned by the two corners that lie furthest to either side of the motion.
+    if (SDL_fabsf(x1 - x0) > 1e-5f || SDL_fabsf(y1 - y0) > 1e-5f) {
+        float cx = (y1 - y0) <= 0.0f ? half : -half; // Sign of the normal (-dy, dx)
+        float cy = (x1 - x0) >= 0.0f ? half : -half;
+        const SDL_FPoint band[4] = {
+            {x0 + cx, y0 + cy},
+            {x1 + cx, y1 + cy},
+            {x1 - cx, y1 - cy},
+            {x0 - cx, y0 - cy},
+        };
+        stroke_batch_add_quad(&app->dab_batch, band, fcolor);
     }
+
+    SDL_FRect rect = {x1 - half, y1 - half, (float)side, (float)side};
+    stroke_batch_add_rect(&app->dab_batch, &rect, fcolor);
 }
 
 static void draw_square_dab_callback(int x, int y, void *userdata)
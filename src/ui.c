@@ -111,25 +111,25 @@ static void draw_backgrounds(App *app,
 
     // Draw diagonal line icon (color is set by the logic above)
     int p = TOOL_SELECTOR_SIZE / 4;
-    if (!SDL_RenderLine(app->ren,
-                        line_r->x + p,
-                        line_r->y + line_r->h - p,
-                        line_r->x + line_r->w - p,
-                        line_r->y + p)) {
+    if (!perf_render_line(app->ren,
+                          line_r->x + p,
+                          line_r->y + line_r->h - p,
+                          line_r->x + line_r->w - p,
+                          line_r->y + p)) {
         SDL_Log("UI: Failed to draw line icon: %s", SDL_GetError());
     }
-    if (!SDL_RenderLine(app->ren,
-                        line_r->x + p + 1,
-                        line_r->y + line_r->h - p,
-                        line_r->x + line_r->w - p + 1,
-                        line_r->y + p)) {
+    if (!perf_render_line(app->ren,
+                          line_r->x + p + 1,
+                          line_r->y + line_r->h - p,
+                          line_r->x + line_r->w - p + 1,
+                          line_r->y + p)) {
         SDL_Log("UI: Failed to draw line icon shadow 1: %s", SDL_GetError());
     }
-    if (!SDL_RenderLine(app->ren,
-                        line_r->x + p,
-                        line_r->y + line_r->h - p - 1,
-                        line_r->x + line_r->w - p,
-                        line_r->y + p - 1)) {
+    if (!perf_render_line(app->ren,
+                          line_r->x + p,
+                          line_r->y + line_r->h - p - 1,
+                          line_r->x + line_r->w - p,
+                          line_r->y + p - 1)) {
         SDL_Log("UI: Failed to draw line icon shadow 2: %s", SDL_GetError());
     }
 
@@ -174,6 +174,21 @@ static void draw_backgrounds(App *app,
     }
 }
 
+// Returns the brush preview ring for the given radius, rebuilding it only when the radius changes.
+// A failed build is not retried until then; NULL means drawing the ring directly.
+static SDL_Texture *get_preview_ring_texture(App *app, int radius)
+{
+    if (app->preview_ring_radius == radius) {
+        return app->preview_ring_texture;
+    }
+    if (app->preview_ring_texture) {
+        SDL_DestroyTexture(app->preview_ring_texture);
+    }
+    app->preview_ring_texture = draw_create_hollow_circle_texture(app->ren, radius);
+    app->preview_ring_radius = radius;
+    return app->preview_ring_texture;
+}
+
 static void draw_previews(App *app,
                           const SDL_FRect *brush_r,
                           const SDL_FRect *water_r,
@@ -193,12 +208,29 @@ static void draw_previews(App *app,
     Uint8 ir = 255 - app->current_color.r;
     Uint8 ig = 255 - app->current_color.g;
     Uint8 ib = 255 - app->current_color.b;
-    if (!SDL_SetRenderDrawColor(app->ren, ir, ig, ib, 255)) {
-        SDL_Log("UI: Failed to set brush preview color: %s", SDL_GetError());
-    }
     float br_cx = brush_r->x + brush_r->w / 2.0f;
     float br_cy = brush_r->y + brush_r->h / 2.0f;
-    draw_hollow_circle(app->ren, br_cx, br_cy, preview_radius);
+    SDL_Texture *ring_tex = get_preview_ring_texture(app, preview_radius);
+    if (ring_tex) {
+        if (!SDL_SetTextureColorMod(ring_tex, ir, ig, ib)) {
+            SDL_Log("UI: Failed to set brush preview color: %s", SDL_GetError());
+        }
+        // Whole-pixel placement keeps the 2 px ring sharp.
+        SDL_FRect ring_r = {
+            SDL_roundf(br_cx) - preview_radius,
+            SDL_roundf(br_cy) - preview_radius,
+            (float)(2 * preview_radius + 1),
+            (float)(2 * preview_radius + 1),
+        };
+        if (!SDL_RenderTexture(app->ren, ring_tex, NULL, &ring_r)) {
+            SDL_Log("UI: Failed to render brush preview: %s", SDL_GetError());
+        }
+    } else {
+        if (!SDL_SetRenderDrawColor(app->ren, ir, ig, ib, 255)) {
+            SDL_Log("UI: Failed to set brush preview color: %s", SDL_GetError());
+        }
+        draw_hollow_circle(app->ren, br_cx, br_cy, preview_radius);
+    }
 
     // Water-marker preview (hollow square)
     Uint8 w_ir = 255 - app->water_marker_color.r;
@@ -265,16 +297,17 @@ static void draw_previews(App *app,
 
     // Current emoji preview
     SDL_Texture *emoji_tex = NULL;
+    SDL_FRect emoji_src;
     int emoji_w = 0, emoji_h = 0;
     bool has_emoji = false;
     if (app->current_tool == TOOL_EMOJI) {
         has_emoji = palette_get_emoji_info(
                         app->palette, app->emoji_selected_palette_idx,
-                        &emoji_tex, &emoji_w, &emoji_h);
+                        &emoji_tex, &emoji_src, &emoji_w, &emoji_h);
     } else { // Not emoji tool, so show a default emoji
         has_emoji = emoji_renderer_get_default_texture_info(
                         app->palette->emoji_renderer_instance,
-                        &emoji_tex, &emoji_w, &emoji_h);
+                        &emoji_tex, &emoji_src, &emoji_w, &emoji_h);
     }
 
     if (has_emoji && emoji_tex) {
@@ -297,7 +330,7 @@ static void draw_previews(App *app,
             render_w,
             render_h,
         };
-        if (!SDL_RenderTexture(app->ren, emoji_tex, NULL, &dst_rect)) {
+        if (!SDL_RenderTexture(app->ren, emoji_tex, &emoji_src, &dst_rect)) {
             SDL_Log("UI: Failed to render emoji preview texture: %s", SDL_GetError());
         }
     }
@@ -5,7 +5,7 @@ typedef struct App App;
 #define INITIAL_WINDOW_WIDTH 800
 #define INITIAL_WINDOW_HEIGHT 600
 
-#define RESIZE_DEBOUNCE_MS 200 // Milliseconds for resize debouncing
+#define RESIZE_DEBOUNCE_MS 50 // Milliseconds for resize debouncing
 
 /* --------------------------------------------------------------------
    Palette & Toolbar layout